@@ -221,6 +221,10 @@ namespace Urho3D
 
 		int key = eventData[P_KEY].GetInt();
 
+		// Ctrl+1-9 belong to the scene editor camera bookmarks, Alt+1-9 to its quick selection sets
+		if (key >= '1' && key <= '9' && (eventData[P_QUALIFIERS].GetInt() & (QUAL_CTRL | QUAL_ALT)))
+			return;
+
 		// Close console (if open) or exit when ESC is pressed
 		if (key == KEY_ESC)
 		{
@@ -4,6 +4,7 @@
 #include "../Scene/Component.h"
 #include "../Scene/Node.h"
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 #include "../UI/Window.h"
 #include "EditorData.h"
 #include "../UI/Text.h"
@@ -45,6 +46,7 @@
 #include "../Resource/XMLFile.h"
 #include "../Core/StringUtils.h"
 #include "../Math/Quaternion.h"
+#include "../Container/HashSet.h"
 #include "MenuBarUI.h"
 #include "../UI/Menu.h"
 #include "../UI/MessageBox.h"
@@ -54,6 +56,7 @@
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "AttributeInspector.h"
+#include "AttributeVariableEvents.h"
 #include "../IO/File.h"
 #include "../IO/Deserializer.h"
 #include "../UI/Menu.h"
@@ -64,8 +67,19 @@
 #include "ToolBarUI.h"
 #include "../UI/CheckBox.h"
 #include "GizmoScene3D.h"
+#include "HandleOverlay.h"
 #include "../Physics/RigidBody.h"
 #include "../UI/ListView.h"
+#include "SceneSnapshot.h"
+#include "SceneSaveThread.h"
+#include "PrefabCache.h"
+#include "../Core/Profiler.h"
+#include "../Container/Sort.h"
+#include "../Math/Frustum.h"
+#include "../Graphics/OctreeQuery.h"
+
+#include <cstdio>
+#include <cstring>
 
 
 namespace Urho3D
@@ -103,10 +117,18 @@ namespace Urho3D
 		"Point"
 	};
 
+	/// scene variable holding the camera bookmarks, position and rotation per slot
+	static const StringHash CAMERA_BOOKMARKS_VAR("EditorCameraBookmarks");
+	static const unsigned MAX_CAMERA_BOOKMARKS = 9;
+	/// selection sets reachable with Alt+1-9, named by their number
+	static const unsigned MAX_QUICK_SELECTION_SETS = 9;
+
 	EPScene3D::EPScene3D(Context* context) : EditorPlugin(context),
 		showGrid_(true),
 		grid2DMode_(false),
-		sceneModified(false)
+		sceneModified(false),
+		viewportLayout_(VIEWPORT_SINGLE),
+		viewsDirty_(true)
 	{
 		ui_ = GetSubsystem<UI>();
 		input_ = GetSubsystem<Input>();
@@ -121,7 +143,11 @@ namespace Urho3D
 			editor_ = editorData_->GetEditor();
 
 		gridColor = Color(0.1f, 0.1f, 0.1f);
-		gridSubdivisionColor = Color(0.05f, 0.05f, 0.05f);
+		gridSize = 32;
+		gridSubdivisions = 8;
+		gridScale = 8.0f;
+		gridLevel_ = M_MAX_INT;
+		gridFade_ = -1.0f;
 		gridXColor = Color(0.5f, 0.1f, 0.1f);
 		gridYColor = Color(0.1f, 0.5f, 0.1f);
 		gridZColor = Color(0.1f, 0.1f, 0.5f);
@@ -148,6 +174,9 @@ namespace Urho3D
 		renderingDebug = false;
 		physicsDebug = false;
 		octreeDebug = false;
+		debugDrawDirty_ = true;
+		debugDrawBoundsDirty_ = true;
+		debugDrawMaxComponents = 1024;
 
         /// mouse pick handling
 		pickMode = PICK_GEOMETRIES;
@@ -160,6 +189,44 @@ namespace Urho3D
 				/// scene update handling
 		runUpdate = false;
 		revertOnPause = true;
+		loadingHierarchyCount_ = 0;
+		revertData = new SceneSnapshot(context_);
+		playFixedTimeStep = 0.0f;
+		playMaxSteps = 4;
+		playTimeAccumulator_ = 0.0f;
+		playTimeScale = 1.0f;
+		playStepCount = 10;
+		pendingPlaySteps_ = 0;
+		playPhaseStart_ = 0;
+		playPhase_ = -1;
+		for (unsigned i = 0; i < MAX_PLAY_TIMINGS; ++i)
+			playTimings_[i] = 0.0f;
+		autosaveInterval = 0.0f;
+		autosaveTimer_ = 0.0f;
+		saveThread_ = new SceneSaveThread(context_);
+		flyTime_ = 0.0f;
+		flyDuration = 0.75f;
+		statsUpdateInterval = 0.25f;
+		statsTimer_ = 0.0f;
+		statsModes_ = -1;
+		for (unsigned i = 0; i < 5; ++i)
+			statsCounters_[i] = M_MAX_UNSIGNED;
+		statsFrameHistory = 128;
+		frameTimes_.Reserve(statsFrameHistory);
+		sortedFrameTimes_.Reserve(statsFrameHistory);
+		frameTimeIndex_ = 0;
+		editorModeString_.Reserve(256);
+		renderStatsString_.Reserve(256);
+		frameStatsString_.Reserve(256);
+		prefabCache_ = new PrefabCache(context_);
+		spatialSnap_ = new SpatialSnap(context_);
+		selectionSets_ = new SelectionSets(context_);
+		spatialSnapMode = SPATIAL_SNAP_NONE;
+		spatialSnapDistance = 0.5f;
+		pivotMode = PIVOT_MEDIAN;
+		pivotValid_ = false;
+		pivotContainsScene_ = false;
+		pivotNodesDirty_ = true;
 		toolBarDirty = true;
 
 	}
@@ -237,8 +304,12 @@ namespace Urho3D
 				SubscribeToEvent(E_ENDVIEWUPDATE, HANDLER(EPScene3D, HandleEndViewUpdate));
 				SubscribeToEvent(E_BEGINVIEWRENDER, HANDLER(EPScene3D, HandleBeginViewRender));
 				SubscribeToEvent(E_ENDVIEWRENDER, HANDLER(EPScene3D, HandleEndViewRender));
+				SubscribeToEvent(E_KEYDOWN, HANDLER(EPScene3D, HandleViewInput));
+				SubscribeToEvent(E_MOUSEBUTTONDOWN, HANDLER(EPScene3D, HandleViewInput));
+				SubscribeToEvent(E_MOUSEBUTTONUP, HANDLER(EPScene3D, HandleViewInput));
+				SubscribeToEvent(E_MOUSEWHEEL, HANDLER(EPScene3D, HandleViewInput));
 				gizmo_->ShowGizmo();
-				activeView->SetAutoUpdate(true);
+				QueueViewUpdates();
 			}
 			else
 			{
@@ -251,23 +322,63 @@ namespace Urho3D
 				UnsubscribeFromEvent(E_ENDVIEWUPDATE);
 				UnsubscribeFromEvent(E_BEGINVIEWRENDER);
 				UnsubscribeFromEvent(E_ENDVIEWRENDER);
+				UnsubscribeFromEvent(E_KEYDOWN);
+				UnsubscribeFromEvent(E_MOUSEBUTTONDOWN);
+				UnsubscribeFromEvent(E_MOUSEBUTTONUP);
+				UnsubscribeFromEvent(E_MOUSEWHEEL);
+				// The views are in manual update mode, nothing renders while hidden
 				gizmo_->HideGizmo();
-				activeView->SetAutoUpdate(false);
+				handleOverlay_->Hide();
 			}
 		}
 	}
 
+	bool EPScene3D::IsBusy()
+	{
+		Scene* editorScene = editorData_->GetEditorScene();
+		return runUpdate || pendingPlaySteps_ > 0 || editorScene->IsAsyncLoading() || saveThread_->IsSaving() || IsFlying();
+	}
+
 	void EPScene3D::Update(float timeStep)
 	{
-		UpdateStats(timeStep);
+		// Nothing is rendered while idle, so the stats would not change
+		if (!editor_->IsIdle())
+			UpdateStats(timeStep);
+		UpdateGridTransform();
+		UpdateSceneSave(timeStep);
 
 		if (runUpdate)
+			UpdatePlayScene(timeStep);
+		else if (pendingPlaySteps_ > 0)
+		{
+			float step = playFixedTimeStep > 0.0f ? playFixedTimeStep : 1.0f / 60.0f;
+			for (; pendingPlaySteps_ > 0; --pendingPlaySteps_)
+				RunPlayStep(step * playTimeScale);
+			// Paused without revertOnPause the edited scene holds the play state, the next step clones it again
+			if (!revertOnPause)
+			{
+				ApplyPlayScene();
+				DiscardPlayScene();
+			}
+			viewsDirty_ = true;
+		}
+		// The editor scene has updates disabled, so background loading has to be driven here. While loading, scene update
+		// only advances the load.
+		else if (editorData_->GetEditorScene()->IsAsyncLoading())
 			editorData_->GetEditorScene()->Update(timeStep);
 
+		// A running or loading scene changes every frame
+		if (viewsDirty_ || runUpdate || editorData_->GetEditorScene()->IsAsyncLoading())
+		{
+			QueueViewUpdates();
+			viewsDirty_ = false;
+		}
+
 		if (toolBarDirty && editorView_->IsToolBarVisible())
 			UpdateToolBar();
 
 		gizmo_->UpdateGizmo();
+		UpdateCameraFlight(timeStep);
 
 		if (ui_->HasModalElement() || ui_->GetFocusElement() != NULL)
 		{
@@ -275,6 +386,37 @@ namespace Urho3D
 			return;
 		}
 
+		if (input_->GetKeyPress('F') && !input_->GetQualifierDown(QUAL_CTRL))
+			FocusSelection();
+
+		// Camera bookmarks, Ctrl+Shift+1-9 stores and Ctrl+1-9 flies to one
+		if (input_->GetQualifierDown(QUAL_CTRL))
+		{
+			for (unsigned i = 0; i < MAX_CAMERA_BOOKMARKS; ++i)
+			{
+				if (!input_->GetKeyPress('1' + i))
+					continue;
+				if (input_->GetQualifierDown(QUAL_SHIFT))
+					SetCameraBookmark(i);
+				else
+					FlyToCameraBookmark(i);
+			}
+		}
+
+		// Quick selection sets, Alt+Shift+1-9 stores and Alt+1-9 selects one
+		if (input_->GetQualifierDown(QUAL_ALT))
+		{
+			for (unsigned i = 0; i < MAX_QUICK_SELECTION_SETS; ++i)
+			{
+				if (!input_->GetKeyPress('1' + i))
+					continue;
+				if (input_->GetQualifierDown(QUAL_SHIFT))
+					StoreSelectionSet(String(i + 1));
+				else
+					SelectSelectionSet(String(i + 1));
+			}
+		}
+
 		// Move camera
 		if (!input_->GetKeyDown(KEY_LCTRL))
 		{
@@ -415,23 +557,253 @@ namespace Urho3D
 
 	void EPScene3D::ResetCamera()
 	{
-		//for (uint i = 0; i < viewports.length; ++i)
-		activeView->ResetCamera();
+		for (unsigned int i = 0; i < views_.Size(); ++i)
+			views_[i]->ResetCamera();
 	}
 
 	void EPScene3D::ReacquireCameraYawPitch()
 	{
-		//for (uint i = 0; i < viewports.length; ++i)
-		activeView->ReacquireCameraYawPitch();
+		for (unsigned int i = 0; i < views_.Size(); ++i)
+			views_[i]->ReacquireCameraYawPitch();
 	}
 
 	void EPScene3D::UpdateViewParameters()
 	{
-		//for (uint i = 0; i < viewports.length; ++i)
+		for (unsigned int i = 0; i < views_.Size(); ++i)
+		{
+			views_[i]->camera_->SetNearClip(viewNearClip);
+			views_[i]->camera_->SetFarClip(viewFarClip);
+			views_[i]->camera_->SetFov(viewFov);
+		}
+		QueueViewUpdates();
+	}
+
+	void EPScene3D::SetViewportLayout(ViewportLayout layout)
+	{
+		unsigned int numViews = (unsigned int)layout;
+
+		// Keep the active view if it stays, its children (stats and loading bar) would be removed with it
+		if (activeView != NULL && (unsigned int)(views_.Find(activeView) - views_.Begin()) >= numViews)
+			SetActiveView(views_[0]);
+
+		while (views_.Size() > numViews)
+		{
+			views_.Back()->Remove();
+			views_.Pop();
+		}
+		while (views_.Size() < numViews)
+			views_.Push(SharedPtr<EPScene3DView>(CreateView(views_.Size())));
+
+		viewportLayout_ = layout;
+		if (activeView == NULL)
+			SetActiveView(views_[0]);
+
+		LayoutViews();
+		QueueViewUpdates();
+	}
+
+	void EPScene3D::SetActiveView(EPScene3DView* view)
+	{
+		if (view == NULL)
+			return;
+
+		activeView = view;
+		cameraNode_ = view->GetCameraNode();
+		camera_ = view->GetCamera();
+
+		// The overlays follow the active view
+		if (editorModeText != NULL)
+			view->AddChild(editorModeText);
+		if (renderStatsText != NULL)
+			view->AddChild(renderStatsText);
+		if (frameStatsText != NULL)
+			view->AddChild(frameStatsText);
+		if (playStatsText != NULL)
+			view->AddChild(playStatsText);
+		if (loadingBar_ != NULL)
+			view->AddChild(loadingBar_);
+	}
+
+	void EPScene3D::QueueViewUpdates()
+	{
+		for (unsigned int i = 0; i < views_.Size(); ++i)
+			views_[i]->QueueUpdate();
+	}
+
+	void EPScene3D::SetCameraBookmark(unsigned index)
+	{
+		if (index >= MAX_CAMERA_BOOKMARKS)
+			return;
+
+		Scene* editorScene = editorData_->GetEditorScene();
+		VariantVector bookmarks = editorScene->GetVar(CAMERA_BOOKMARKS_VAR).GetVariantVector();
+		if (bookmarks.Size() < MAX_CAMERA_BOOKMARKS * 2)
+			bookmarks.Resize(MAX_CAMERA_BOOKMARKS * 2);
+
+		bookmarks[index * 2] = cameraNode_->GetWorldPosition();
+		bookmarks[index * 2 + 1] = cameraNode_->GetWorldRotation();
+		editorScene->SetVar(CAMERA_BOOKMARKS_VAR, bookmarks);
+		sceneModified = true;
+	}
+
+	bool EPScene3D::FlyToCameraBookmark(unsigned index)
+	{
+		const VariantVector& bookmarks = editorData_->GetEditorScene()->GetVar(CAMERA_BOOKMARKS_VAR).GetVariantVector();
+		if (index * 2 + 1 >= bookmarks.Size() || bookmarks[index * 2].GetType() != VAR_VECTOR3)
+			return false;
+
+		FlyTo(bookmarks[index * 2].GetVector3(), bookmarks[index * 2 + 1].GetQuaternion());
+		return true;
+	}
+
+	void EPScene3D::FlyTo(const Vector3& position, const Quaternion& rotation)
+	{
+		// Load what the destination shows while flying, so arriving does not stall on resource loads
+		PrefetchView(position, rotation);
+
+		flyCameraNode_ = cameraNode_;
+		flyStartPosition_ = cameraNode_->GetWorldPosition();
+		flyStartRotation_ = cameraNode_->GetWorldRotation();
+		flyTargetPosition_ = position;
+		flyTargetRotation_ = rotation;
+		flyTime_ = 0.0f;
+	}
+
+	void EPScene3D::UpdateCameraFlight(float timeStep)
+	{
+		if (flyCameraNode_ == NULL)
+			return;
+
+		// Any manual camera control takes over, the movement keys only move the camera without Ctrl
+		static const int moveKeys[] = { 'W', 'S', 'A', 'D', 'E', 'Q', KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT, KEY_PAGEUP, KEY_PAGEDOWN };
+		bool manualControl = input_->GetMouseButtonDown(MOUSEB_RIGHT) || input_->GetMouseButtonDown(MOUSEB_MIDDLE) ||
+			input_->GetMouseMoveWheel() != 0;
+		for (unsigned i = 0; i < sizeof(moveKeys) / sizeof(moveKeys[0]) && !manualControl; ++i)
+			manualControl = input_->GetKeyDown(moveKeys[i]) && !input_->GetKeyDown(KEY_LCTRL);
+		if (manualControl)
+		{
+			flyCameraNode_.Reset();
+			ReacquireCameraYawPitch();
+			return;
+		}
+
+		flyTime_ += timeStep;
+		float t = flyDuration > 0.0f ? Min(flyTime_ / flyDuration, 1.0f) : 1.0f;
+		// Ease in and out
+		float s = t * t * (3.0f - 2.0f * t);
+		flyCameraNode_->SetWorldPosition(flyStartPosition_.Lerp(flyTargetPosition_, s));
+		flyCameraNode_->SetWorldRotation(flyStartRotation_.Slerp(flyTargetRotation_, s));
+
+		if (t >= 1.0f)
+		{
+			flyCameraNode_.Reset();
+			ReacquireCameraYawPitch();
+		}
+	}
+
+	void EPScene3D::PrefetchView(const Vector3& position, const Quaternion& rotation)
+	{
+		Octree* octree = editorData_->GetEditorScene()->GetComponent<Octree>();
+		if (octree == NULL || activeView->GetHeight() <= 0)
+			return;
+
+		Frustum frustum;
+		float aspectRatio = (float)activeView->GetWidth() / (float)activeView->GetHeight();
+		Matrix3x4 transform(position, rotation, 1.0f);
+		if (camera_->IsOrthographic())
+			frustum.DefineOrtho(camera_->GetOrthoSize(), aspectRatio, camera_->GetZoom(), camera_->GetNearClip(), camera_->GetFarClip(), transform);
+		else
+			frustum.Define(camera_->GetFov(), aspectRatio, camera_->GetZoom(), camera_->GetNearClip(), camera_->GetFarClip(), transform);
+
+		PODVector<Drawable*> drawables;
+		FrustumOctreeQuery query(drawables, frustum, DRAWABLE_GEOMETRY);
+		octree->GetDrawables(query);
+
+		// The resources of a drawable are normally loaded along with it, textures with their materials, so this only finds
+		// something while the scene is still loading in the background or after a resource attribute was changed to a
+		// resource that is not loaded yet. Nothing is uploaded ahead of time to the GPU, there is no texture streaming.
+		for (unsigned i = 0; i < drawables.Size(); ++i)
+		{
+			Drawable* drawable = drawables[i];
+			const Vector<AttributeInfo>* attributes = drawable->GetAttributes();
+			if (attributes == NULL)
+				continue;
+
+			for (unsigned j = 0; j < attributes->Size(); ++j)
+			{
+				VariantType type = attributes->At(j).type_;
+				if (type != VAR_RESOURCEREF && type != VAR_RESOURCEREFLIST)
+					continue;
+
+				Variant value = drawable->GetAttribute(j);
+				if (type == VAR_RESOURCEREF)
+				{
+					const ResourceRef& ref = value.GetResourceRef();
+					if (!ref.name_.Empty() && cache_->GetExistingResource(ref.type_, ref.name_) == NULL)
+						cache_->BackgroundLoadResource(ref.type_, ref.name_, false);
+				}
+				else
+				{
+					const ResourceRefList& refs = value.GetResourceRefList();
+					for (unsigned k = 0; k < refs.names_.Size(); ++k)
+					{
+						if (!refs.names_[k].Empty() && cache_->GetExistingResource(refs.type_, refs.names_[k]) == NULL)
+							cache_->BackgroundLoadResource(refs.type_, refs.names_[k], false);
+					}
+				}
+			}
+		}
+	}
+
+	EPScene3DView* EPScene3D::CreateView(unsigned index)
+	{
+		EPScene3DView* view = window_->CreateChild<EPScene3DView>("Scene3DView" + String(index));
+		view->SetDefaultStyle(editorData_->GetDefaultStyle());
+		view->SetView(editorData_->GetEditorScene());
+		if (playScene_)
+			view->SetRenderScene(playScene_);
+		view->CreateViewportContextUI(editorData_->GetDefaultStyle(), editorData_->GetIconStyle());
+		// Render only when queued or the camera moved
+		view->SetAutoUpdate(false);
+		view->GetCamera()->SetFillMode(fillMode);
+
+		// The additional views look along the axes
+		switch (index)
+		{
+		case 1:
+			view->SetDefaultCamera(Vector3(0.0f, 100.0f, 0.0f), Quaternion(90.0f, 0.0f, 0.0f), true);
+			break;
+		case 2:
+			view->SetDefaultCamera(Vector3(0.0f, 0.0f, -100.0f), Quaternion::IDENTITY, true);
+			break;
+		case 3:
+			view->SetDefaultCamera(Vector3(100.0f, 0.0f, 0.0f), Quaternion(0.0f, -90.0f, 0.0f), true);
+			break;
+		default:
+			break;
+		}
+		view->ResetCamera();
+
+		return view;
+	}
+
+	void EPScene3D::LayoutViews()
+	{
+		if (window_ == NULL || views_.Empty())
+			return;
+
+		const IntVector2& size = window_->GetSize();
+		int columns = views_.Size() > 1 ? 2 : 1;
+		int rows = views_.Size() > 2 ? 2 : 1;
+
+		for (unsigned int i = 0; i < views_.Size(); ++i)
 		{
-			activeView->camera_->SetNearClip(viewNearClip);
-			activeView->camera_->SetFarClip(viewFarClip);
-			activeView->camera_->SetFov(viewFov);
+			int column = i % columns;
+			int row = i / columns;
+			IntVector2 position(column * size.x_ / columns, row * size.y_ / rows);
+			IntVector2 end((column + 1) * size.x_ / columns, (row + 1) * size.y_ / rows);
+			views_[i]->SetPosition(position);
+			views_[i]->SetSize(end - position);
 		}
 	}
 
@@ -443,16 +815,24 @@ namespace Urho3D
 		activeView->AddChild(editorModeText);
 		renderStatsText = new Text(context_);
 		activeView->AddChild(renderStatsText);
+		frameStatsText = new Text(context_);
+		activeView->AddChild(frameStatsText);
+		playStatsText = new Text(context_);
+		activeView->AddChild(playStatsText);
 
 		if (window_->GetWidth() >= 1200)
 		{
 			SetupStatsBarText(editorModeText, font, 35, 64, HA_LEFT, VA_TOP);
 			SetupStatsBarText(renderStatsText, font, -4, 64, HA_RIGHT, VA_TOP);
+			SetupStatsBarText(frameStatsText, font, -4, 78, HA_RIGHT, VA_TOP);
+			SetupStatsBarText(playStatsText, font, -4, 92, HA_RIGHT, VA_TOP);
 		}
 		else
 		{
 			SetupStatsBarText(editorModeText, font, 1, 1, HA_LEFT, VA_TOP);
 			SetupStatsBarText(renderStatsText, font, 1, 15, HA_LEFT, VA_TOP);
+			SetupStatsBarText(frameStatsText, font, 1, 29, HA_LEFT, VA_TOP);
+			SetupStatsBarText(playStatsText, font, 1, 43, HA_LEFT, VA_TOP);
 		}
 	}
 
@@ -467,32 +847,130 @@ namespace Urho3D
 		text->SetPriority(-100);
 	}
 
+	/// seconds to milliseconds, clamped so a formatted time has at most 7 characters
+	static float ClampStatsMs(float seconds)
+	{
+		return Clamp(seconds * 1000.0f, 0.0f, 99999.0f);
+	}
+
 	void EPScene3D::UpdateStats(float timeStep)
 	{
-		editorModeText->SetText(String(
-			"Mode: " + editModeText[editMode] +
-			"  Axis: " + axisModeText[axisMode] +
-			"  Pick: " + pickModeText[pickMode] +
-			"  Fill: " + fillModeText[fillMode] +
-			"  Updates: " + (runUpdate ? "Running" : "Paused")));
+		// Frame times are recorded every frame, the texts only at the update rate
+		if (frameTimes_.Size() < statsFrameHistory)
+			frameTimes_.Push(timeStep);
+		else
+			frameTimes_[frameTimeIndex_] = timeStep;
+		frameTimeIndex_ = (frameTimeIndex_ + 1) % statsFrameHistory;
+
+		statsTimer_ += timeStep;
+		if (statsTimer_ < statsUpdateInterval)
+			return;
+		statsTimer_ = 0.0f;
+
+		// sprintf only, the older MSVC runtimes have no snprintf. Every line stays well below the buffer size: the
+		// numbers are clamped and the names are length checked.
+		char buffer[256];
 
-		renderStatsText->SetText(String(
-			"Tris: " + String(renderer->GetNumPrimitives()) +
-			"  Batches: " + String(renderer->GetNumBatches()) +
-			"  Lights: " + String(renderer->GetNumLights(true)) +
-			"  Shadowmaps: " + String(renderer->GetNumShadowMaps(true)) +
-			"  Occluders: " + String(renderer->GetNumOccluders(true))));
+		int modes = editMode | (axisMode << 4) | (pickMode << 8) | (fillMode << 12) | ((runUpdate ? 1 : 0) << 16);
+		if (modes != statsModes_)
+		{
+			statsModes_ = modes;
+			String modeText = "Mode: " + editModeText[editMode] + "  Axis: " + axisModeText[axisMode] + "  Pick: " +
+				pickModeText[pickMode] + "  Fill: " + fillModeText[fillMode] + "  Updates: " + (runUpdate ? "Running" : "Paused");
+			SetStatsText(editorModeText, editorModeString_, modeText.CString());
+		}
+
+		unsigned counters[5] = {
+			renderer->GetNumPrimitives(),
+			renderer->GetNumBatches(),
+			renderer->GetNumLights(true),
+			renderer->GetNumShadowMaps(true),
+			renderer->GetNumOccluders(true)
+		};
+		if (memcmp(counters, statsCounters_, sizeof(counters)) != 0)
+		{
+			memcpy(statsCounters_, counters, sizeof(counters));
+			sprintf(buffer, "Tris: %u  Batches: %u  Lights: %u  Shadowmaps: %u  Occluders: %u",
+				counters[0], counters[1], counters[2], counters[3], counters[4]);
+			SetStatsText(renderStatsText, renderStatsString_, buffer);
+		}
 
-		editorModeText->SetSize(editorModeText->GetMinSize());
-		renderStatsText->SetSize(renderStatsText->GetMinSize());
+		// Percentiles over the recorded frames, the scratch buffer never grows past the history size
+		sortedFrameTimes_.Resize(frameTimes_.Size());
+		for (unsigned i = 0; i < frameTimes_.Size(); ++i)
+			sortedFrameTimes_[i] = frameTimes_[i];
+		Sort(sortedFrameTimes_.Begin(), sortedFrameTimes_.End());
+
+		unsigned last = sortedFrameTimes_.Size() - 1;
+		int length = sprintf(buffer, "Frame ms  p50: %.1f  p95: %.1f  p99: %.1f  max: %.1f",
+			ClampStatsMs(sortedFrameTimes_[last / 2]), ClampStatsMs(sortedFrameTimes_[last * 95 / 100]),
+			ClampStatsMs(sortedFrameTimes_[last * 99 / 100]), ClampStatsMs(sortedFrameTimes_[last]));
+		if (length > 0)
+			FormatProfilerStats(buffer + length, sizeof(buffer) - length);
+		SetStatsText(frameStatsText, frameStatsString_, buffer);
+
+		playStatsText->SetVisible(playScene_ != NULL);
+		if (playScene_)
+		{
+			char stepText[32];
+			if (playFixedTimeStep > 0.0f)
+				sprintf(stepText, "%.1f ms", ClampStatsMs(playFixedTimeStep));
+			else
+				strcpy(stepText, "frame");
+
+			// The timings are milliseconds already, the time scale is clamped to 1/16-16
+			sprintf(buffer, "Play x%.2f  dt: %s  Step ms  logic: %.2f  anim: %.2f  physics: %.2f  post: %.2f  total: %.2f",
+				playTimeScale, stepText,
+				ClampStatsMs(playTimings_[PLAY_TIMING_LOGIC] / 1000.0f), ClampStatsMs(playTimings_[PLAY_TIMING_ANIMATION] / 1000.0f),
+				ClampStatsMs(playTimings_[PLAY_TIMING_PHYSICS] / 1000.0f), ClampStatsMs(playTimings_[PLAY_TIMING_POSTUPDATE] / 1000.0f),
+				ClampStatsMs(playTimings_[PLAY_TIMING_TOTAL] / 1000.0f));
+			SetStatsText(playStatsText, playStatsString_, buffer);
+		}
+	}
+
+	void EPScene3D::SetStatsText(Text* text, String& cache, const char* stats)
+	{
+		if (text == NULL || cache == stats)
+			return;
+
+		cache = stats;
+		text->SetText(cache);
+		text->SetSize(text->GetMinSize());
+	}
+
+	int EPScene3D::FormatProfilerStats(char* buffer, int size)
+	{
+		// The profiler only exists in profiling builds
+		Profiler* profiler = GetSubsystem<Profiler>();
+		if (profiler == NULL)
+			return 0;
+
+		// Skip single child wrapper blocks down to the per subsystem blocks
+		ProfilerBlock* block = profiler->GetRootBlock();
+		while (block != NULL && block->children_.Size() == 1)
+			block = block->children_[0];
+		if (block == NULL)
+			return 0;
+
+		int length = 0;
+		for (unsigned i = 0; i < block->children_.Size() && i < 4 && length < size; ++i)
+		{
+			ProfilerBlock* child = block->children_[i];
+			// Name, separators and a clamped time of at most 7 characters
+			if (length + (int)strlen(child->name_) + 16 >= size)
+				break;
+			length += sprintf(buffer + length, "  %s: %.1f", child->name_, Min(child->frameTime_ / 1000.0f, 99999.0f));
+		}
+
+		return length;
 	}
 
 	void EPScene3D::SetFillMode(FillMode fM_)
 	{
 		fillMode = fM_;
-// 		for (uint i = 0; i < viewports.length; ++i)
-// 			viewports[i].camera.fillMode = fillMode_;
-		camera_->SetFillMode(fM_);
+		for (unsigned int i = 0; i < views_.Size(); ++i)
+			views_[i]->GetCamera()->SetFillMode(fM_);
+		QueueViewUpdates();
 	}
 
 	void EPScene3D::Start()
@@ -501,20 +979,29 @@ namespace Urho3D
 		window_ = new UIElement(context_);
 		window_->SetDefaultStyle(editorData_->GetDefaultStyle());
 
-		activeView = window_->CreateChild<EPScene3DView>("Scene3DView");
-		activeView->SetDefaultStyle(editorData_->GetDefaultStyle());
-		activeView->SetView(editorData_->GetEditorScene());
-		activeView->CreateViewportContextUI(editorData_->GetDefaultStyle(), editorData_->GetIconStyle());
-		cameraNode_ = activeView->GetCameraNode();
-		camera_ = activeView->GetCamera();
-		activeView->SetAutoUpdate(true);
+		SetViewportLayout(VIEWPORT_SINGLE);
 
 		CreateGrid();
 		ShowGrid();
 		CreateStatsBar();
+		CreateLoadingBar();
 
 		SubscribeToEvent(window_, E_RESIZED, HANDLER(EPScene3D, HandleResizeView));
 
+		Scene* editorScene = editorData_->GetEditorScene();
+		SubscribeToEvent(editorScene, E_NODEADDED, HANDLER(EPScene3D, HandleSceneChanged));
+		SubscribeToEvent(editorScene, E_NODEREMOVED, HANDLER(EPScene3D, HandleSceneChanged));
+		SubscribeToEvent(editorScene, E_COMPONENTADDED, HANDLER(EPScene3D, HandleSceneChanged));
+		SubscribeToEvent(editorScene, E_COMPONENTREMOVED, HANDLER(EPScene3D, HandleSceneChanged));
+		SubscribeToEvent(editorSelection_, E_EDITORSELECTIONCHANGED, HANDLER(EPScene3D, HandleEditorSelectionChanged));
+		// Inspector edits are sent by the attribute UI elements, the containers apply them before the unspecific subscribers run
+		SubscribeToEvent(AEE_BOOLVARCHANGED, HANDLER(EPScene3D, HandleAttributeEdited));
+		SubscribeToEvent(AEE_STRINGVARCHANGED, HANDLER(EPScene3D, HandleAttributeEdited));
+		SubscribeToEvent(AEE_NUMBERVARCHANGED, HANDLER(EPScene3D, HandleAttributeEdited));
+		SubscribeToEvent(AEE_ENUMVARCHANGED, HANDLER(EPScene3D, HandleAttributeEdited));
+		SubscribeToEvent(AEE_RESREFVARCHANGED, HANDLER(EPScene3D, HandleAttributeEdited));
+		selectionSets_->SetScene(editorScene);
+
 		//////////////////////////////////////////////////////////////////////////
 		/// Menu Bar entries
 
@@ -528,6 +1015,11 @@ namespace Urho3D
 		editorView_->GetGetMenuBar()->CreateMenuItem("Scene", "Load node as local", A_LOADNODEASLOCAL_VAR);
 		editorView_->GetGetMenuBar()->CreateMenuItem("Scene", "Save node as", A_SAVENODEAS_VAR);
 
+		editorView_->GetGetMenuBar()->CreateMenuItem("Scene", "Single viewport", A_VIEWPORTSINGLE_VAR);
+		editorView_->GetGetMenuBar()->CreateMenuItem("Scene", "Split viewport", A_VIEWPORTSPLIT_VAR);
+		editorView_->GetGetMenuBar()->CreateMenuItem("Scene", "Quad viewport", A_VIEWPORTQUAD_VAR);
+		editorView_->GetGetMenuBar()->CreateMenuItem("Scene", "Frame selection", A_FRAMESELECTION_VAR);
+
 		createMenu_ = editorView_->GetGetMenuBar()->CreateMenu("Create");
 
 		editorView_->GetGetMenuBar()->CreateMenuItem("Create", "Replicated node", A_CREATEREPNODE_VAR, 0, 0, true, "Create Replicated node");
@@ -605,6 +1097,9 @@ namespace Urho3D
 
 		gizmo_->CreateGizmo();
 		gizmo_->ShowGizmo();
+
+		handleOverlay_ = new HandleOverlay(context_);
+		handleOverlay_->Create(editorData_->GetIconStyle());
 	}
 
 	void EPScene3D::CreateMiniToolBarUI()
@@ -699,6 +1194,20 @@ namespace Urho3D
 		if (checkbox->IsChecked() != revertOnPause)
 			checkbox->SetChecked(revertOnPause);
 		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarRevertOnPause));
+		checkbox = minitool->CreateToolBarToggle("RunUpdateGroup", "RunUpdateStep");
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarRunUpdateStep));
+		minitool->CreateToolBarSpacer(4);
+
+		e = minitool->CreateGroup("PlayTimeGroup", LM_HORIZONTAL);
+		toolBarToggles.Push(e);
+		checkbox = minitool->CreateToolBarToggle("PlayTimeGroup", "FixedTimeStep");
+		if (checkbox->IsChecked() != (playFixedTimeStep > 0.0f))
+			checkbox->SetChecked(playFixedTimeStep > 0.0f);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarFixedTimeStep));
+		checkbox = minitool->CreateToolBarToggle("PlayTimeGroup", "TimeScaleDown");
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarTimeScaleDown));
+		checkbox = minitool->CreateToolBarToggle("PlayTimeGroup", "TimeScaleUp");
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarTimeScaleUp));
 		minitool->CreateToolBarSpacer(4);
 
 
@@ -761,6 +1270,41 @@ namespace Urho3D
 			checkbox->SetChecked((snapScaleMode == SNAP_SCALE_QUARTER));
 		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarSnapScaleModeQuarter));
 
+		e = minitool->CreateGroup("SpatialSnapGroup", LM_HORIZONTAL);
+		toolBarToggles.Push(e);
+		checkbox = minitool->CreateToolBarToggle("SpatialSnapGroup", "SnapSurface");
+		if (checkbox->IsChecked() != (spatialSnapMode == SPATIAL_SNAP_SURFACE))
+			checkbox->SetChecked(spatialSnapMode == SPATIAL_SNAP_SURFACE);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarSnapSurface));
+		checkbox = minitool->CreateToolBarToggle("SpatialSnapGroup", "SnapVertex");
+		if (checkbox->IsChecked() != (spatialSnapMode == SPATIAL_SNAP_VERTEX))
+			checkbox->SetChecked(spatialSnapMode == SPATIAL_SNAP_VERTEX);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarSnapVertex));
+		checkbox = minitool->CreateToolBarToggle("SpatialSnapGroup", "SnapBounds");
+		if (checkbox->IsChecked() != (spatialSnapMode == SPATIAL_SNAP_BOUNDS))
+			checkbox->SetChecked(spatialSnapMode == SPATIAL_SNAP_BOUNDS);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarSnapBounds));
+
+		minitool->CreateToolBarSpacer(4);
+		e = minitool->CreateGroup("PivotModeGroup", LM_HORIZONTAL);
+		toolBarToggles.Push(e);
+		checkbox = minitool->CreateToolBarToggle("PivotModeGroup", "PivotMedian");
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_MEDIAN))
+			checkbox->SetChecked(pivotMode == PIVOT_MEDIAN);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarPivotMedian));
+		checkbox = minitool->CreateToolBarToggle("PivotModeGroup", "PivotBoundsCenter");
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_BOUNDS_CENTER))
+			checkbox->SetChecked(pivotMode == PIVOT_BOUNDS_CENTER);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarPivotBoundsCenter));
+		checkbox = minitool->CreateToolBarToggle("PivotModeGroup", "PivotActive");
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_ACTIVE))
+			checkbox->SetChecked(pivotMode == PIVOT_ACTIVE);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarPivotActive));
+		checkbox = minitool->CreateToolBarToggle("PivotModeGroup", "PivotIndividual");
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_INDIVIDUAL))
+			checkbox->SetChecked(pivotMode == PIVOT_INDIVIDUAL);
+		SubscribeToEvent(checkbox, E_TOGGLED, HANDLER(EPScene3D, ToolBarPivotIndividual));
+
 		minitool->CreateToolBarSpacer(4);
 		e = minitool->CreateGroup("PickModeGroup", LM_HORIZONTAL);
 		toolBarToggles.Push(e);
@@ -827,22 +1371,188 @@ namespace Urho3D
 			return centerPoint;
 	}
 
-	void EPScene3D::DrawNodeDebug(Node* node, DebugRenderer* debug, bool drawNode /*= true*/)
+	BoundingBox EPScene3D::GetSelectionBounds()
+	{
+		BoundingBox bounds;
+
+		// The debug draw cache already has the drawables of the selected subtrees, their world bounds are cached by the drawables
+		UpdateDebugDrawCache();
+		for (HashMap<unsigned, DebugDrawCache>::Iterator i = debugDrawCache_.Begin(); i != debugDrawCache_.End(); ++i)
+		{
+			DebugDrawCache& cache = i->second_;
+			if (cache.node_ == NULL)
+				continue;
+
+			UpdateDebugDrawBounds(cache);
+			if (cache.bounds_.defined_)
+				bounds.Merge(cache.bounds_);
+			else if (cache.node_ != editorData_->GetEditorScene())
+				bounds.Merge(cache.node_->GetWorldPosition());
+		}
+
+		for (unsigned int i = 0; i < editorSelection_->GetNumSelectedComponents(); ++i)
+		{
+			Component* component = editorSelection_->GetSelectedComponents()[i];
+			Drawable* drawable = dynamic_cast<Drawable*>(component);
+			if (drawable != NULL)
+				bounds.Merge(drawable->GetWorldBoundingBox());
+			else if (component->GetNode() != NULL)
+				bounds.Merge(component->GetNode()->GetWorldPosition());
+		}
+
+		return bounds;
+	}
+
+	bool EPScene3D::FocusSelection()
 	{
-		if (drawNode)
+		BoundingBox bounds = GetSelectionBounds();
+		if (!bounds.defined_)
+			return false;
+
+		// Frame the bounding sphere, it fits regardless of the view direction
+		Vector3 center = bounds.Center();
+		float radius = Max(bounds.HalfSize().Length(), 0.1f);
+		float aspectRatio = activeView->GetHeight() > 0 ? (float)activeView->GetWidth() / (float)activeView->GetHeight() : 1.0f;
+		Quaternion rotation = cameraNode_->GetWorldRotation();
+
+		float distance;
+		if (camera_->IsOrthographic())
+		{
+			// Ortho size is the view height, the narrower side has to fit the sphere
+			camera_->SetOrthoSize(2.0f * radius * Max(1.0f, 1.0f / aspectRatio) * camera_->GetZoom());
+			distance = 2.0f * radius + camera_->GetNearClip();
+		}
+		else
+		{
+			// Half angle of the narrower side, zoom narrows the view
+			float tanHalfFov = tan(camera_->GetFov() * M_DEGTORAD * 0.5f) / camera_->GetZoom();
+			float halfFov = atan(tanHalfFov * Min(1.0f, aspectRatio));
+			distance = radius / sin(halfFov);
+		}
+
+		FlyTo(center - rotation * Vector3::FORWARD * distance, rotation);
+		return true;
+	}
+
+	void EPScene3D::DrawSelectionDebug(DebugRenderer* debug)
+	{
+		UpdateDebugDrawCache();
+		handleOverlay_->BeginHandles();
+
+		unsigned int numDrawn = 0;
+		for (HashMap<unsigned, DebugDrawCache>::Iterator i = debugDrawCache_.Begin(); i != debugDrawCache_.End(); ++i)
+		{
+			DebugDrawCache& cache = i->second_;
+			Node* node = cache.node_;
+			if (node == NULL)
+				continue;
+
 			debug->AddNode(node, 1.0f, false);
 
+			// Lights, zones and collision shapes go to the handle overlay, which draws at most its handle limit with two draw
+			// calls. Shapes it can not draw fall back to their debug geometry under the draw cap.
+			for (unsigned int j = 0; j < cache.handles_.Size() && !handleOverlay_->IsFull(); ++j)
+			{
+				Component* component = cache.handles_[j];
+				if (component == NULL || !component->IsEnabledEffective() || handleOverlay_->AddHandle(component))
+					continue;
+				if (numDrawn < debugDrawMaxComponents)
+				{
+					component->DrawDebugGeometry(debug, false);
+					++numDrawn;
+				}
+			}
+
+			// Over the draw cap only draw the combined bounds of the subtree, so a huge selection can't bring the editor to its knees
+			if (cache.lod_ || numDrawn + cache.components_.Size() > debugDrawMaxComponents)
+			{
+				if (debugDrawBoundsDirty_ || !cache.bounds_.defined_)
+					UpdateDebugDrawBounds(cache);
+				if (cache.bounds_.defined_)
+					debug->AddBoundingBox(cache.bounds_, Color(1.0f, 1.0f, 0.0f), false);
+				continue;
+			}
+
+			for (unsigned int j = 0; j < cache.components_.Size(); ++j)
+			{
+				Component* component = cache.components_[j];
+				if (component != NULL)
+					component->DrawDebugGeometry(debug, false);
+			}
+			numDrawn += cache.components_.Size();
+		}
+
+		if (handleOverlay_->EndHandles(GetRenderScene(), camera_))
+			viewsDirty_ = true;
+
+		// The edited scene does not move while playing, the play scene is updated instead
+		debugDrawBoundsDirty_ = false;
+	}
+
+	void EPScene3D::UpdateDebugDrawCache()
+	{
+		if (!debugDrawDirty_)
+			return;
+
+		const Vector<Node*>& selectedNodes = editorSelection_->GetSelectedNodes();
+		debugDrawCache_.Clear();
+		for (unsigned int i = 0; i < selectedNodes.Size(); ++i)
+		{
+			if (selectedNodes[i] != NULL)
+				FillDebugDrawCache(selectedNodes[i], debugDrawCache_[selectedNodes[i]->GetID()]);
+		}
+
+		debugDrawDirty_ = false;
+		debugDrawBoundsDirty_ = true;
+		viewsDirty_ = true;
+	}
+
+	void EPScene3D::FillDebugDrawCache(Node* node, DebugDrawCache& cache)
+	{
+		cache.node_ = node;
+		cache.components_.Clear();
+		cache.handles_.Clear();
+		cache.bounds_.defined_ = false;
+		CollectNodeDebug(node, cache);
+		cache.lod_ = cache.components_.Size() > debugDrawMaxComponents;
+	}
+
+	void EPScene3D::CollectNodeDebug(Node* node, DebugDrawCache& cache)
+	{
 		// Exception for the scene to avoid bringing the editor to its knees: drawing either the whole hierarchy or the subsystem-
 		// components can have a large performance hit. Also do not draw terrain child nodes due to their large amount
 		// (TerrainPatch component itself draws nothing as debug geometry)
-		if (node != editorData_->GetEditorScene() && node->GetComponent<Terrain>() == NULL)
+		if (node == editorData_->GetEditorScene() || node->GetComponent<Terrain>() != NULL)
+			return;
+
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		for (unsigned int j = 0; j < components.Size(); ++j)
 		{
-			for (unsigned int j = 0; j < node->GetNumComponents(); ++j)
-				node->GetComponents()[j]->DrawDebugGeometry(debug, false);
+			if (HandleOverlay::IsHandleComponent(components[j]))
+				cache.handles_.Push(WeakPtr<Component>(components[j]));
+			else
+				cache.components_.Push(WeakPtr<Component>(components[j]));
+		}
+
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned int k = 0; k < children.Size(); ++k)
+			CollectNodeDebug(children[k], cache);
+	}
 
-			// To avoid cluttering the view, do not draw the node axes for child nodes
-			for (unsigned int k = 0; k < node->GetNumChildren(); ++k)
-				DrawNodeDebug(node->GetChildren()[k], debug, false);
+	void EPScene3D::UpdateDebugDrawBounds(DebugDrawCache& cache)
+	{
+		cache.bounds_.defined_ = false;
+		for (unsigned int j = 0; j < cache.components_.Size(); ++j)
+		{
+			Drawable* drawable = dynamic_cast<Drawable*>(cache.components_[j].Get());
+			if (drawable != NULL)
+				cache.bounds_.Merge(drawable->GetWorldBoundingBox());
+		}
+		for (unsigned int j = 0; j < cache.handles_.Size(); ++j)
+		{
+			Drawable* drawable = dynamic_cast<Drawable*>(cache.handles_[j].Get());
+			if (drawable != NULL)
+				cache.bounds_.Merge(drawable->GetWorldBoundingBox());
 		}
 	}
 
@@ -852,39 +1562,85 @@ namespace Urho3D
 
 		if (adjust.Length() > M_EPSILON)
 		{
-			for (unsigned int i = 0; i < editorSelection_->GetNumEditNodes(); ++i)
+			if (moveSnap)
 			{
-				if (moveSnap)
-				{
-					float moveStepScaled = moveStep * snapScale;
-					adjust.x_ = floor(adjust.x_ / moveStepScaled + 0.5f) * moveStepScaled;
-					adjust.y_ = floor(adjust.y_ / moveStepScaled + 0.5f) * moveStepScaled;
-					adjust.z_ = floor(adjust.z_ / moveStepScaled + 0.5f) * moveStepScaled;
-				}
+				float moveStepScaled = moveStep * snapScale;
+				adjust.x_ = floor(adjust.x_ / moveStepScaled + 0.5f) * moveStepScaled;
+				adjust.y_ = floor(adjust.y_ / moveStepScaled + 0.5f) * moveStepScaled;
+				adjust.z_ = floor(adjust.z_ / moveStepScaled + 0.5f) * moveStepScaled;
+			}
 
-				Node* node = editorSelection_->GetEditNodes()[i];
-				Vector3 nodeAdjust = adjust;
-				if (axisMode == AXIS_LOCAL && editorSelection_->GetNumEditNodes() == 1)
-					nodeAdjust = node->GetWorldRotation() * nodeAdjust;
+			// The whole selection follows the snap of the first node
+			Vector3 snapOffset = spatialSnapMode != SPATIAL_SNAP_NONE ? GetSpatialSnapOffset(adjust) : Vector3::ZERO;
+
+			// In local mode the selection moves along the axes of the active node, or each node along its own axes
+			const PODVector<Node*>& roots = GetTransformRoots();
+			bool individualAxes = axisMode == AXIS_LOCAL && pivotMode == PIVOT_INDIVIDUAL;
+			Vector3 sharedAdjust = GetGizmoRotation() * adjust;
+
+			Node* lastParent = NULL;
+			Matrix3x4 parentInverse;
+			for (unsigned int i = 0; i < roots.Size(); ++i)
+			{
+				Node* node = roots[i];
+				Vector3 nodeAdjust = individualAxes ? node->GetWorldRotation() * adjust : sharedAdjust;
 
 				Vector3 worldPos = node->GetWorldPosition();
 				Vector3 oldPos = node->GetPosition();
 
-				worldPos += nodeAdjust;
+				worldPos += nodeAdjust + snapOffset;
 
-				if (node->GetParent() == NULL)
-					node->SetPosition(worldPos);
-				else
-					node->SetPosition(node->GetParent()->WorldToLocal(worldPos));
+				// Siblings are usually next to each other, the parent transform is inverted once for all of them
+				Node* parent = node->GetParent();
+				if (parent != lastParent || i == 0)
+				{
+					parentInverse = parent != NULL ? parent->GetWorldTransform().Inverse() : Matrix3x4::IDENTITY;
+					lastParent = parent;
+				}
+				node->SetPosition(parentInverse * worldPos);
 
 				if (node->GetPosition() != oldPos)
 					moved = true;
 			}
+
+			if (individualAxes)
+				pivotValid_ = false;
+			else
+				pivot_ += sharedAdjust + snapOffset;
+		}
+
+		if (moved)
+		{
+			debugDrawBoundsDirty_ = true;
+			viewsDirty_ = true;
 		}
 
 		return moved;
 	}
 
+	Vector3 EPScene3D::GetSpatialSnapOffset(const Vector3& adjust)
+	{
+		const Vector<Node*>& editNodes = editorSelection_->GetEditNodes();
+		Octree* octree = editorData_->GetEditorScene()->GetComponent<Octree>();
+		if (editNodes.Empty() || octree == NULL)
+			return Vector3::ZERO;
+
+		Node* lead = editNodes[0];
+		Vector3 leadAdjust = GetGizmoRotation() * adjust;
+
+		// Keep following the unsnapped position while the node stays where the last snap put it, otherwise small drag steps
+		// would never get it out of a snap
+		Vector3 current = lead->GetWorldPosition();
+		if (snapLeadNode_ != lead || (current - snapLastPosition_).LengthSquared() > M_EPSILON * M_EPSILON)
+			snapFreePosition_ = current;
+		snapFreePosition_ += leadAdjust;
+
+		Vector3 snapped = spatialSnap_->Snap(spatialSnapMode, octree, lead, snapFreePosition_, editNodes, spatialSnapDistance);
+		snapLeadNode_ = lead;
+		snapLastPosition_ = snapped;
+		return snapped - (current + leadAdjust);
+	}
+
 	bool EPScene3D::RotateNodes(Vector3 adjust)
 	{
 		bool moved = false;
@@ -901,31 +1657,154 @@ namespace Urho3D
 		{
 			moved = true;
 
-			for (unsigned int i = 0; i < editorSelection_->GetNumEditNodes(); ++i)
+			const PODVector<Node*>& roots = GetTransformRoots();
+			const Vector3& pivot = GetPivot();
+			Quaternion rotQuat(adjust.x_, adjust.y_, adjust.z_);
+			// Rotation in world space, in local mode the adjustment is around the gizmo axes
+			Quaternion gizmoRotation = GetGizmoRotation();
+			Quaternion sharedDelta = gizmoRotation * rotQuat * gizmoRotation.Inverse();
+			bool individual = pivotMode == PIVOT_INDIVIDUAL;
+			bool individualAxes = individual && axisMode == AXIS_LOCAL;
+
+			// One SetTransform per node and one inverted parent transform per run of siblings, so large selections stay interactive
+			Node* lastParent = NULL;
+			Matrix3x4 parentInverse;
+			Quaternion parentRotationInverse;
+			for (unsigned int i = 0; i < roots.Size(); ++i)
 			{
-				Node* node = editorSelection_->GetEditNodes()[i];
-				Quaternion rotQuat(adjust.x_, adjust.y_, adjust.z_);
-				if (axisMode == AXIS_LOCAL && editorSelection_->GetNumEditNodes() == 1)
-					node->SetRotation(node->GetRotation() * rotQuat);
-				else
+				Node* node = roots[i];
+				Node* parent = node->GetParent();
+				if (parent != lastParent || i == 0)
 				{
-					Vector3 offset = node->GetWorldPosition();/// \todo -gizmoAxisX.axisRay.origin;
+					if (parent != NULL)
+					{
+						parentInverse = parent->GetWorldTransform().Inverse();
+						parentRotationInverse = parent->GetWorldRotation().Inverse();
+					}
+					else
+					{
+						parentInverse = Matrix3x4::IDENTITY;
+						parentRotationInverse = Quaternion::IDENTITY;
+					}
+					lastParent = parent;
+				}
+
+				Quaternion worldRotation = node->GetWorldRotation();
+				Quaternion delta = individualAxes ? worldRotation * rotQuat * worldRotation.Inverse() : sharedDelta;
+				Vector3 worldPos = node->GetWorldPosition();
+				if (!individual)
+					worldPos = pivot + delta * (worldPos - pivot);
+
+				node->SetTransform(parentInverse * worldPos, parentRotationInverse * delta * worldRotation);
+			}
+		}
+
+		if (moved)
+		{
+			debugDrawBoundsDirty_ = true;
+			viewsDirty_ = true;
+		}
+
+		return moved;
+	}
+
+	const Vector3& EPScene3D::GetPivot()
+	{
+		UpdatePivotCache();
+		return pivot_;
+	}
+
+	Quaternion EPScene3D::GetGizmoRotation()
+	{
+		if (axisMode == AXIS_WORLD || editorSelection_->GetNumEditNodes() == 0)
+			return Quaternion::IDENTITY;
+		return editorSelection_->GetEditNodes()[0]->GetWorldRotation();
+	}
+
+	const PODVector<Node*>& EPScene3D::GetTransformRoots()
+	{
+		UpdatePivotCache();
+		return transformRoots_;
+	}
 
-					if (node->GetParent() != NULL && node->GetParent()->GetWorldRotation() != Quaternion(1, 0, 0, 0))
-						rotQuat = node->GetParent()->GetWorldRotation().Inverse() * rotQuat * node->GetParent()->GetWorldRotation();
+	bool EPScene3D::IsSceneEdited()
+	{
+		UpdatePivotCache();
+		return pivotContainsScene_;
+	}
+
+	void EPScene3D::SetPivotMode(PivotMode mode)
+	{
+		if (mode == pivotMode)
+			return;
+		pivotMode = mode;
+		pivotValid_ = false;
+		toolBarDirty = true;
+	}
 
-					node->SetRotation(rotQuat * node->GetRotation());
-					Vector3 newPosition = rotQuat * offset; /// \todo gizmoAxisX.axisRay.origin +
+	void EPScene3D::UpdatePivotCache()
+	{
+		if (!pivotNodesDirty_ && pivotValid_)
+			return;
+
+		const Vector<Node*>& editNodes = editorSelection_->GetEditNodes();
+		Node* editorScene = editorData_->GetEditorScene();
+		if (pivotNodesDirty_)
+		{
+			pivotNodesDirty_ = false;
 
-					if (node->GetParent() != NULL)
-						newPosition = node->GetParent()->WorldToLocal(newPosition);
+			// A node under another edited node moves with it, transforming it too would apply the change twice
+			HashSet<Node*> editSet;
+			for (unsigned int i = 0; i < editNodes.Size(); ++i)
+				editSet.Insert(editNodes[i]);
 
-					node->SetPosition(newPosition);
+			transformRoots_.Clear();
+			pivotContainsScene_ = false;
+			for (unsigned int i = 0; i < editNodes.Size(); ++i)
+			{
+				Node* node = editNodes[i];
+				if (node == editorScene)
+				{
+					pivotContainsScene_ = true;
+					continue;
 				}
+
+				bool nested = false;
+				for (Node* parent = node->GetParent(); parent != NULL && !nested; parent = parent->GetParent())
+					nested = editSet.Contains(parent);
+				if (!nested)
+					transformRoots_.Push(node);
 			}
 		}
 
-		return moved;
+		pivot_ = Vector3::ZERO;
+		if (pivotMode == PIVOT_ACTIVE && !editNodes.Empty() && editNodes[0] != editorScene)
+			pivot_ = editNodes[0]->GetWorldPosition();
+		else
+		{
+			BoundingBox bounds;
+			if (pivotMode == PIVOT_BOUNDS_CENTER)
+				bounds = GetSelectionBounds();
+
+			if (bounds.defined_)
+				pivot_ = bounds.Center();
+			else
+			{
+				// The median, also where the gizmo of individual origins sits
+				unsigned count = 0;
+				for (unsigned int i = 0; i < editNodes.Size(); ++i)
+				{
+					if (editNodes[i] == editorScene)
+						continue;
+					pivot_ += editNodes[i]->GetWorldPosition();
+					++count;
+				}
+				if (count > 0)
+					pivot_ /= (float)count;
+			}
+		}
+
+		pivotValid_ = true;
 	}
 
 	bool EPScene3D::ScaleNodes(Vector3 adjust)
@@ -970,6 +1849,12 @@ namespace Urho3D
 			}
 		}
 
+		if (moved)
+		{
+			debugDrawBoundsDirty_ = true;
+			viewsDirty_ = true;
+		}
+
 		return moved;
 	}
 
@@ -999,7 +1884,7 @@ namespace Urho3D
 		if (gizmo_->IsGizmoSelected())
 			return;
 
-		DebugRenderer* debug = editorScene->GetComponent<DebugRenderer>();
+		DebugRenderer* debug = GetRenderScene()->GetComponent<DebugRenderer>();
 
 		if (pickMode == PICK_UI_ELEMENTS)
 		{
@@ -1064,9 +1949,8 @@ namespace Urho3D
 			if (editorScene->GetComponent<PhysicsWorld>() == NULL)
 				return;
 
-			// If we are not running the actual physics update, refresh collisions before raycasting
-			if (!runUpdate)
-				editorScene->GetComponent<PhysicsWorld>()->UpdateCollisions();
+			// The edited scene never runs the physics update, refresh collisions before raycasting
+			editorScene->GetComponent<PhysicsWorld>()->UpdateCollisions();
 
 			PhysicsRaycastResult result;
 			editorScene->GetComponent<PhysicsWorld>()->RaycastSingle(result,cameraRay, camera_->GetFarClip());
@@ -1192,6 +2076,86 @@ namespace Urho3D
 			hierarchyList->ClearSelection();
 	}
 
+	void EPScene3D::SelectObjects(const PODVector<Node*>& nodes, const PODVector<Component*>& components)
+	{
+		HierarchyWindow* hierarchyWindow = editor_->GetHierarchyWindow();
+		ListView* hierarchyList = hierarchyWindow->GetHierarchyList();
+
+		// Expand the parent chains first, every ancestor only once
+		HashSet<unsigned> ancestorIDs;
+		HashSet<unsigned> noIDs;
+		for (unsigned i = 0; i < nodes.Size() + components.Size(); ++i)
+		{
+			Node* current = i < nodes.Size() ? nodes[i] : components[i - nodes.Size()]->GetNode();
+			while (current != NULL && !ancestorIDs.Contains(current->GetID()))
+			{
+				ancestorIDs.Insert(current->GetID());
+				current = current->GetParent();
+			}
+		}
+		PODVector<unsigned> indices;
+		hierarchyWindow->GetListIndices(ancestorIDs, noIDs, indices);
+		for (unsigned i = 0; i < indices.Size(); ++i)
+			hierarchyList->Expand(indices[i], true);
+
+		HashSet<unsigned> nodeIDs;
+		for (unsigned i = 0; i < nodes.Size(); ++i)
+			nodeIDs.Insert(nodes[i]->GetID());
+		HashSet<unsigned> componentIDs;
+		for (unsigned i = 0; i < components.Size(); ++i)
+			componentIDs.Insert(components[i]->GetID());
+		hierarchyWindow->GetListIndices(nodeIDs, componentIDs, indices);
+
+		// This sends one selection change with the delta to the current selection
+		hierarchyList->SetSelections(indices);
+	}
+
+	void EPScene3D::StoreSelectionSet(const String& name)
+	{
+		selectionSets_->StoreSet(name, editorSelection_->GetSelectedNodes(), editorSelection_->GetSelectedComponents());
+		sceneModified = true;
+	}
+
+	bool EPScene3D::SelectSelectionSet(const String& name)
+	{
+		PODVector<Node*> nodes;
+		PODVector<Component*> components;
+		if (!selectionSets_->GetSet(name, nodes, components))
+			return false;
+
+		SelectObjects(nodes, components);
+		return true;
+	}
+
+	bool EPScene3D::SelectQuery(const String& name)
+	{
+		SelectionQuery query;
+		if (!selectionSets_->GetQuery(name, query))
+			return false;
+
+		SelectQuery(query);
+		return true;
+	}
+
+	void EPScene3D::SelectQuery(const SelectionQuery& query)
+	{
+		PODVector<Component*> components;
+		selectionSets_->RunQuery(query, components);
+
+		HashSet<Node*> added;
+		PODVector<Node*> nodes;
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			Node* node = components[i]->GetNode();
+			if (!added.Contains(node))
+			{
+				added.Insert(node);
+				nodes.Push(node);
+			}
+		}
+		SelectObjects(nodes, PODVector<Component*>());
+	}
+
 	void EPScene3D::SetMouseMode(bool enable)
 	{
 		if (enable)
@@ -1230,15 +2194,15 @@ namespace Urho3D
 	{
 		using namespace PostRenderUpdate;
 
-		Scene* scene = editorData_->GetEditorScene();
+		// Only the debug geometry of the shown scene is rendered
+		Scene* scene = GetRenderScene();
 
 		DebugRenderer* debug = scene->GetComponent<DebugRenderer>();
 		if (debug == NULL)
 			return;
 
 		// Visualize the currently selected nodes
-		for (unsigned int i = 0; i < editorSelection_->GetNumSelectedNodes(); ++i)
-			DrawNodeDebug(editorSelection_->GetSelectedNodes()[i], debug);
+		DrawSelectionDebug(debug);
 
 		// Visualize the currently selected components
 		for (unsigned int i = 0; i < editorSelection_->GetNumSelectedComponents(); ++i)
@@ -1266,12 +2230,34 @@ namespace Urho3D
 	{
 		using namespace UIMouseClick;
 
+		// Clicking into another view makes it the active one
+		UIElement* element = ui_->GetElementAt(ui_->GetCursorPosition());
+		for (unsigned int i = 0; i < views_.Size(); ++i)
+		{
+			if (views_[i].Get() == element && views_[i] != activeView)
+			{
+				SetActiveView(views_[i]);
+				break;
+			}
+		}
+
 		ViewRaycast(true);
 	}
 
 	void EPScene3D::ViewMouseMove(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace MouseMove;
+
+		// Dragging may edit the scene from anywhere (gizmo, attribute inspector), hovering only changes the gizmo
+		if (eventData[P_BUTTONS].GetInt() != 0)
+			viewsDirty_ = true;
+		else if (activeView != NULL && ui_->GetElementAt(ui_->GetCursorPosition()) == activeView)
+			activeView->QueueUpdate();
+	}
+
+	void EPScene3D::HandleViewInput(StringHash eventType, VariantMap& eventData)
+	{
+		viewsDirty_ = true;
 	}
 
 	void EPScene3D::ViewMouseClickEnd(StringHash eventType, VariantMap& eventData)
@@ -1301,8 +2287,7 @@ namespace Urho3D
 
 	void EPScene3D::HandleResizeView(StringHash eventType, VariantMap& eventData)
 	{
-		if (activeView)
-			activeView->SetSize(window_->GetSize());
+		LayoutViews();
 	}
 
 	void EPScene3D::HandleMenuBarAction(StringHash eventType, VariantMap& eventData)
@@ -1322,9 +2307,17 @@ namespace Urho3D
 		else if (action == A_SAVESCENE_VAR || action == A_SAVESCENEAS_VAR)
 		{
 			editor_->CreateFileSelector("Save scene as", "Save", "Cancel", editorData_->uiScenePath, editorData_->uiSceneFilters, editorData_->uiSceneFilter);
-			editor_->GetUIFileSelector()->SetFileName(GetFileNameAndExtension(editorData_->GetEditorScene()->GetFileName()));
+			editor_->GetUIFileSelector()->SetFileName(GetFileNameAndExtension(sceneFileName));
 			SubscribeToEvent(editor_->GetUIFileSelector(), E_FILESELECTED, HANDLER(EPScene3D, HandleSaveSceneFile));
 		}
+		else if (action == A_FRAMESELECTION_VAR)
+			FocusSelection();
+		else if (action == A_VIEWPORTSINGLE_VAR)
+			SetViewportLayout(VIEWPORT_SINGLE);
+		else if (action == A_VIEWPORTSPLIT_VAR)
+			SetViewportLayout(VIEWPORT_SPLIT);
+		else if (action == A_VIEWPORTQUAD_VAR)
+			SetViewportLayout(VIEWPORT_QUAD);
 		else if (action == A_LOADNODEASREP_VAR)
 		{
 			instantiateMode = REPLICATED;
@@ -1366,6 +2359,51 @@ namespace Urho3D
 		}
 	}
 
+	void EPScene3D::HandleSceneChanged(StringHash eventType, VariantMap& eventData)
+	{
+		debugDrawDirty_ = true;
+		// Removed nodes may leave dangling pointers in the transform roots
+		pivotNodesDirty_ = true;
+		pivotValid_ = false;
+		viewsDirty_ = true;
+	}
+
+	void EPScene3D::HandleEditorSelectionChanged(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace EditorSelectionChanged;
+
+		const VariantVector& removedNodes = eventData[P_REMOVEDNODES].GetVariantVector();
+		const VariantVector& addedNodes = eventData[P_ADDEDNODES].GetVariantVector();
+
+		// Only the changed subtrees are collected, unless the whole cache is rebuilt anyway
+		if (!debugDrawDirty_ && (!removedNodes.Empty() || !addedNodes.Empty()))
+		{
+			for (unsigned int i = 0; i < removedNodes.Size(); ++i)
+				debugDrawCache_.Erase(removedNodes[i].GetUInt());
+
+			Scene* editorScene = editorData_->GetEditorScene();
+			for (unsigned int i = 0; i < addedNodes.Size(); ++i)
+			{
+				unsigned id = addedNodes[i].GetUInt();
+				Node* node = editorScene->GetNode(id);
+				if (node != NULL)
+					FillDebugDrawCache(node, debugDrawCache_[id]);
+			}
+		}
+
+		// A component selection changes the edit nodes too, they are the common node of the components
+		pivotNodesDirty_ = true;
+		pivotValid_ = false;
+		viewsDirty_ = true;
+	}
+
+	void EPScene3D::HandleAttributeEdited(StringHash eventType, VariantMap& eventData)
+	{
+		// A transform or model edit moves the bounds, which are not followed every frame like the node positions
+		debugDrawDirty_ = true;
+		pivotValid_ = false;
+	}
+
 	void EPScene3D::HandleMessageAcknowledgement(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace MessageACK;
@@ -1399,8 +2437,14 @@ namespace Urho3D
 		// Clear stored script attributes
 		//scriptAttributes.Clear();
 
+		// A scene still loading would go on creating nodes in the cleared scene
+		StopSceneLoading();
+
 		Editor* editor = editorData_->GetEditor();
 		editor->GetHierarchyWindow()->SetSuppressSceneChanges(true);
+		// Drop the play scene first, stopping without revertOnPause would write it into the scene that is cleared
+		DiscardPlayScene();
+		StopSceneUpdate();
 
 		// Create a scene with default values, these will be overridden when loading scenes
 		editorData_->GetEditorScene()->Clear();
@@ -1411,8 +2455,7 @@ namespace Urho3D
 		//cache.ReleaseAllResources(false);
 
 		sceneModified = false;
-		revertData = NULL;
-		StopSceneUpdate();
+		sceneFileName.Clear();
 
 		//		UpdateWindowTitle();
 		//		DisableInspectorLock();
@@ -1458,6 +2501,7 @@ namespace Urho3D
 		if (fileName.Empty())
 			return false;
 
+		Scene* editorScene = editorData_->GetEditorScene();
 		ui_->GetCursor()->SetShape(CS_BUSY);
 
 		// Always load the scene from the filesystem, not from resource paths
@@ -1469,8 +2513,9 @@ namespace Urho3D
 			return false;
 		}
 
-		File file(context_);
-		if (!file.Open(fileName, FILE_READ))
+		// The scene keeps the file open while loading in the background
+		SharedPtr<File> file(new File(context_));
+		if (!file->Open(fileName, FILE_READ))
 		{
 			LOGERRORF("Could not open file %s", fileName.CString());
 
@@ -1486,38 +2531,95 @@ namespace Urho3D
 		// 	if (!rememberResourcePath || !sceneResourcePath.StartsWith(newScenePath, false))
 		// 		SetResourcePath(newScenePath);
 
+		// The new scene replaces one that is still loading
+		StopSceneLoading();
+
 		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(true);
 		sceneModified = false;
-		revertData = NULL;
+		sceneFileName = fileName;
+		DiscardPlayScene();
 		StopSceneUpdate();
 
+		// The selection would point to the nodes of the old scene
+		editorSelection_->ClearSelection();
+		editorSelection_->SendSelectionChanged();
+		editor_->GetAttributeWindow()->Update();
+
+		// Resources are preloaded in the background first, then the nodes are created a few milliseconds per frame
 		String extension = GetExtension(fileName);
-		bool loaded;
+		bool loading;
 		if (extension != ".xml")
-			loaded = editorData_->GetEditorScene()->Load(file);
+			loading = editorScene->LoadAsync(file, LOAD_SCENE_AND_RESOURCES);
 		else
-			loaded = editorData_->GetEditorScene()->LoadXML(file);
+			loading = editorScene->LoadAsyncXML(file, LOAD_SCENE_AND_RESOURCES);
+
+		if (!loading)
+		{
+			editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorScene, true);
+			editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
+			MessageBox(context_, "Could not load scene.\n" + fileName);
+			return false;
+		}
+
+		// The root level components are loaded already, the children follow as they arrive
+		editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorScene, true);
+		loadingHierarchyCount_ = editorScene->GetNumChildren();
+
+		UpdateLoadingBar(0.0f, 0, 0, 0, 0);
+		loadingBar_->SetVisible(true);
+
+		SubscribeToEvent(editorScene, E_ASYNCLOADPROGRESS, HANDLER(EPScene3D, HandleAsyncLoadProgress));
+		SubscribeToEvent(editorScene, E_ASYNCLOADFINISHED, HANDLER(EPScene3D, HandleAsyncLoadFinished));
+
+		return true;
+	}
+
+	void EPScene3D::HandleAsyncLoadProgress(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace AsyncLoadProgress;
+
+		UpdateLoadingBar(eventData[P_PROGRESS].GetFloat(), eventData[P_LOADEDNODES].GetInt(), eventData[P_TOTALNODES].GetInt(),
+			eventData[P_LOADEDRESOURCES].GetInt(), eventData[P_TOTALRESOURCES].GetInt());
+		StreamHierarchy();
+	}
+
+	void EPScene3D::StopSceneLoading()
+	{
+		Scene* editorScene = editorData_->GetEditorScene();
+		if (!editorScene->IsAsyncLoading())
+			return;
+
+		editorScene->StopAsyncLoading();
+		UnsubscribeFromEvent(editorScene, E_ASYNCLOADPROGRESS);
+		UnsubscribeFromEvent(editorScene, E_ASYNCLOADFINISHED);
+		loadingBar_->SetVisible(false);
+		loadingHierarchyCount_ = 0;
+		// Set by LoadScene until the load finishes, which it now never does
+		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
+	}
+
+	void EPScene3D::HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData)
+	{
+		Scene* editorScene = editorData_->GetEditorScene();
+		UnsubscribeFromEvent(editorScene, E_ASYNCLOADPROGRESS);
+		UnsubscribeFromEvent(editorScene, E_ASYNCLOADFINISHED);
+
+		StreamHierarchy();
+		loadingBar_->SetVisible(false);
 
 		// Release resources which are not used by the new scene
 		/// \todo this creates an bug in the attribute inspector because the loaded xml files are released
 		cache_->ReleaseAllResources(false);
 
 		// Always pause the scene, and do updates manually
-		editorData_->GetEditorScene()->SetUpdateEnabled(false);
+		editorScene->SetUpdateEnabled(false);
 
 		// 	UpdateWindowTitle();
 		// 	DisableInspectorLock();
-		editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorData_->GetEditorScene(), true);
 		// 	ClearEditActions();
 		//
 
 		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
-		/// \todo
-		editorSelection_->ClearSelection();
-		editor_->GetAttributeWindow()->GetEditNodes() = editorSelection_->GetEditNodes();
-		editor_->GetAttributeWindow()->GetEditComponents() = editorSelection_->GetEditComponents();
-		editor_->GetAttributeWindow()->GetEditUIElements() = editorSelection_->GetEditUIElements();
-		editor_->GetAttributeWindow()->Update();
 		//
 		// 	// global variable to mostly bypass adding mru upon importing tempscene
 		// 	if (!skipMruScene)
@@ -1532,8 +2634,44 @@ namespace Urho3D
 		//
 		// 	// Store all ScriptInstance and LuaScriptInstance attributes
 		// 	UpdateScriptInstances();
+	}
 
-		return loaded;
+	void EPScene3D::StreamHierarchy()
+	{
+		// Top level nodes are loaded with their whole subtree, so every new scene child is complete
+		Scene* editorScene = editorData_->GetEditorScene();
+		const Vector<SharedPtr<Node> >& children = editorScene->GetChildren();
+		for (unsigned int i = loadingHierarchyCount_; i < children.Size(); ++i)
+			editor_->GetHierarchyWindow()->UpdateHierarchyItem(children[i]);
+		loadingHierarchyCount_ = children.Size();
+	}
+
+	void EPScene3D::CreateLoadingBar()
+	{
+		Font* font = cache_->GetResource<Font>("Fonts/Anonymous Pro.ttf");
+
+		loadingBar_ = activeView->CreateChild<BorderImage>("LoadingBar");
+		loadingBar_->SetAlignment(HA_CENTER, VA_CENTER);
+		loadingBar_->SetFixedSize(400, 20);
+		loadingBar_->SetColor(Color(0.1f, 0.1f, 0.1f, 0.8f));
+		loadingBar_->SetVisible(false);
+
+		loadingBarFill_ = loadingBar_->CreateChild<BorderImage>("LoadingBarFill");
+		loadingBarFill_->SetPosition(2, 2);
+		loadingBarFill_->SetFixedSize(0, 16);
+		loadingBarFill_->SetColor(Color(0.2f, 0.5f, 0.2f));
+
+		loadingText_ = loadingBar_->CreateChild<Text>("LoadingText");
+		SetupStatsBarText(loadingText_, font, 0, 0, HA_CENTER, VA_CENTER);
+		loadingText_->SetPriority(0);
+	}
+
+	void EPScene3D::UpdateLoadingBar(float progress, int loadedNodes, int totalNodes, int loadedResources, int totalResources)
+	{
+		loadingBarFill_->SetFixedWidth((int)((loadingBar_->GetWidth() - 4) * Clamp(progress, 0.0f, 1.0f)));
+		loadingText_->SetText("Loading " + String((int)(progress * 100.0f)) + "%  Resources: " + String(loadedResources) + "/" +
+			String(totalResources) + "  Nodes: " + String(loadedNodes) + "/" + String(totalNodes));
+		loadingText_->SetSize(loadingText_->GetMinSize());
 	}
 
 	bool EPScene3D::SaveScene(const String& fileName)
@@ -1541,30 +2679,80 @@ namespace Urho3D
 		if (fileName.Empty())
 			return false;
 
-		ui_->GetCursor()->SetShape(CS_BUSY);
+		Scene* editorScene = editorData_->GetEditorScene();
+		if (editorScene->IsAsyncLoading())
+		{
+			LOGERROR("Can not save a scene while it is loading");
+			return false;
+		}
+
+		// Unpause while capturing so that the scene will work properly when loaded outside the editor. Only the capture
+		// runs here, the file is written by the save thread while editing continues.
+		editorScene->SetUpdateEnabled(true);
+		bool success = saveThread_->Save(editorScene, fileName);
+		editorScene->SetUpdateEnabled(false);
+
+		if (success)
+		{
+			autosaveTimer_ = 0.0f;
+			sceneFileName = fileName;
+			//	UpdateSceneMru(fileName);
+			// Changes made while the file is written belong to the next save
+			sceneModified = false;
+			//	UpdateWindowTitle();
+		}
+		else
+			MessageBox(context_, "Could not save scene successfully!\nSee Urho3D.log for more detail.");
+
+		return success;
+	}
 
-		// Unpause when saving so that the scene will work properly when loaded outside the editor
-		editorData_->GetEditorScene()->SetUpdateEnabled(true);
+	bool EPScene3D::AutosaveScene()
+	{
+		Scene* editorScene = editorData_->GetEditorScene();
+		if (sceneFileName.Empty() || editorScene->IsAsyncLoading())
+			return false;
 
-		MakeBackup(fileName);
-		File file(context_, fileName, FILE_WRITE);
-		String extension = GetExtension(fileName);
+		editorScene->SetUpdateEnabled(true);
+		bool success = saveThread_->Save(editorScene, GetAutosaveFileName());
+		editorScene->SetUpdateEnabled(false);
+		return success;
+	}
 
-		bool success = (extension != ".xml" ? editorData_->GetEditorScene()->Save(file) : editorData_->GetEditorScene()->SaveXML(file));
-		RemoveBackup(success, fileName);
+	String EPScene3D::GetAutosaveFileName() const
+	{
+		return sceneFileName + ".autosave" + GetExtension(sceneFileName);
+	}
 
-		editorData_->GetEditorScene()->SetUpdateEnabled(false);
+	void EPScene3D::UpdateSceneSave(float timeStep)
+	{
+		bool success;
+		String fileName;
+		if (saveThread_->PollFinished(success, fileName) && !success)
+		{
+			if (fileName == GetAutosaveFileName())
+				LOGERROR("Autosave failed: " + fileName);
+			else
+			{
+				// The scene on disk is not the one in the editor
+				sceneModified = true;
+				MessageBox(context_, "Could not save scene successfully!\nSee Urho3D.log for more detail.");
+			}
+		}
 
-		if (success)
+		// Autosave is only useful while there is something to lose, and never while the scene runs
+		if (autosaveInterval <= 0.0f || !sceneModified || runUpdate)
 		{
-			//	UpdateSceneMru(fileName);
-			sceneModified = false;
-			//	UpdateWindowTitle();
+			autosaveTimer_ = 0.0f;
+			return;
 		}
-		else
-			MessageBox(context_, "Could not save scene successfully!\nSee Urho3D.log for more detail.");
 
-		return success;
+		autosaveTimer_ += timeStep;
+		if (autosaveTimer_ >= autosaveInterval && !saveThread_->IsSaving())
+		{
+			autosaveTimer_ = 0.0f;
+			AutosaveScene();
+		}
 	}
 
 	Node* EPScene3D::LoadNode(const String& fileName, Node* parent /*= NULL*/)
@@ -1578,8 +2766,7 @@ namespace Urho3D
 			return NULL;
 		}
 
-		File file(context_);
-		if (!file.Open(fileName, FILE_READ))
+		if (!prefabCache_->Load(fileName))
 		{
 			MessageBox(context_, "Could not open file.\n" + fileName);
 			return NULL;
@@ -1594,7 +2781,7 @@ namespace Urho3D
 		Vector3 position, normal;
 		//	GetSpawnPosition(cameraRay, newNodeDistance, position, normal, 0, true);
 
-		Node* newNode = InstantiateNodeFromFile(&file, position, Quaternion(), 1, parent, instantiateMode);
+		Node* newNode = InstantiateNodeFromFile(fileName, position, Quaternion(), 1, parent, instantiateMode);
 		if (newNode != NULL)
 		{
 			//FocusNode(newNode);
@@ -1631,56 +2818,90 @@ namespace Urho3D
 		return success;
 	}
 
-	Node* EPScene3D::InstantiateNodeFromFile(File* file, const Vector3& position, const Quaternion& rotation, float scaleMod /*= 1.0f*/, Node* parent /*= NULL*/, CreateMode mode /*= REPLICATED*/)
+	Node* EPScene3D::InstantiateNodeFromFile(const String& fileName, const Vector3& position, const Quaternion& rotation, float scaleMod /*= 1.0f*/, Node* parent /*= NULL*/, CreateMode mode /*= REPLICATED*/)
 	{
-		if (file == NULL)
+		Scene* editorScene = editorData_->GetEditorScene();
+		unsigned int numSceneComponent = editorScene->GetNumComponents();
+
+		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(true);
+		Node* newNode = prefabCache_->Instantiate(editorScene, fileName, position, rotation, mode);
+		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
+
+		if (newNode == NULL)
 			return NULL;
 
-		Node* newNode = NULL;
-		unsigned int numSceneComponent = editorData_->GetEditorScene()->GetNumComponents();
+		if (parent != NULL)
+			newNode->SetParent(parent);
+		newNode->SetScale(newNode->GetScale() * scaleMod);
+		AlignToSurface(newNode, position.y_);
 
-		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(true);
+		sceneModified = true;
 
-		String extension = GetExtension(file->GetName());
-		if (extension != ".xml")
-			newNode = editorData_->GetEditorScene()->Instantiate(*file, position, rotation, mode);
+		if (numSceneComponent != editorScene->GetNumComponents())
+			editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorScene);
 		else
-			newNode = editorData_->GetEditorScene()->InstantiateXML(*file, position, rotation, mode);
+			editor_->GetHierarchyWindow()->UpdateHierarchyItem(newNode);
 
-		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
+		return newNode;
+	}
 
-		if (parent != NULL)
-			newNode->SetParent(parent);
+	unsigned EPScene3D::InstantiateNodesFromFile(const String& fileName, const PODVector<Matrix3x4>& transforms, PODVector<Node*>& newNodes, Node* parent /*= NULL*/, CreateMode mode /*= REPLICATED*/)
+	{
+		if (transforms.Empty() || !prefabCache_->Load(fileName))
+			return 0;
 
-		if (newNode != NULL)
+		Scene* editorScene = editorData_->GetEditorScene();
+		unsigned int numSceneComponent = editorScene->GetNumComponents();
+		unsigned int firstNew = newNodes.Size();
+
+		// No per node hierarchy updates, the new items are added in one go at the end
+		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(true);
+		newNodes.Reserve(firstNew + transforms.Size());
+
+		Vector3 position, scale;
+		Quaternion rotation;
+		for (unsigned int i = 0; i < transforms.Size(); ++i)
 		{
-			newNode->SetScale(newNode->GetScale() * scaleMod);
-			// 			if (alignToAABBBottom)
-			// 			{
-			// 				Drawable@ drawable = GetFirstDrawable(newNode);
-			// 				if (drawable !is null)
-			// 				{
-			// 					BoundingBox aabb = drawable.worldBoundingBox;
-			// 					Vector3 aabbBottomCenter(aabb.center.x, aabb.min.y, aabb.center.z);
-			// 					Vector3 offset = aabbBottomCenter - newNode.worldPosition;
-			// 					newNode.worldPosition = newNode.worldPosition - offset;
-			// 				}
-			// 			}
-
-			// Create an undo action for the load
-			// 			CreateNodeAction action;
-			// 			action.Define(newNode);
-			// 			SaveEditAction(action);
-			// 			SetSceneModified();
-			sceneModified = true;
+			transforms[i].Decompose(position, rotation, scale);
+			Node* newNode = prefabCache_->Instantiate(editorScene, fileName, position, rotation, mode);
+			if (newNode == NULL)
+				break;
 
-			if (numSceneComponent != editorData_->GetEditorScene()->GetNumComponents())
-				editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorData_->GetEditorScene());
-			else
-				editor_->GetHierarchyWindow()->UpdateHierarchyItem(newNode);
+			if (parent != NULL)
+				newNode->SetParent(parent);
+			newNode->SetScale(newNode->GetScale() * scale);
+			AlignToSurface(newNode, position.y_);
+			newNodes.Push(newNode);
 		}
 
-		return newNode;
+		editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
+
+		unsigned numCreated = newNodes.Size() - firstNew;
+		if (numCreated == 0)
+			return 0;
+
+		sceneModified = true;
+
+		if (numSceneComponent != editorScene->GetNumComponents())
+			editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorScene);
+		else
+		{
+			PODVector<Node*> created(&newNodes[firstNew], numCreated);
+			editor_->GetHierarchyWindow()->AddHierarchyItems(created);
+		}
+
+		return numCreated;
+	}
+
+	void EPScene3D::AlignToSurface(Node* node, float height)
+	{
+		// With surface snapping the new node stands on its bounds bottom instead of its pivot
+		if (spatialSnapMode != SPATIAL_SNAP_SURFACE)
+			return;
+
+		BoundingBox aabb = spatialSnap_->GetNodeBounds(node);
+		if (aabb.defined_)
+			node->SetWorldPosition(node->GetWorldPosition() + Vector3(0.0f, height - aabb.min_.y_, 0.0f));
 	}
 
 	Node* EPScene3D::CreateNode(CreateMode mode)
@@ -1805,6 +3026,20 @@ namespace Urho3D
 		if (checkbox->IsChecked() != revertOnPause)
 			checkbox->SetChecked(revertOnPause);
 
+		// The step and time scale toggles act as buttons
+		checkbox = (CheckBox*)toolBar->GetChild("RunUpdateStep", true);
+		if (checkbox->IsChecked())
+			checkbox->SetChecked(false);
+		checkbox = (CheckBox*)toolBar->GetChild("TimeScaleDown", true);
+		if (checkbox->IsChecked())
+			checkbox->SetChecked(false);
+		checkbox = (CheckBox*)toolBar->GetChild("TimeScaleUp", true);
+		if (checkbox->IsChecked())
+			checkbox->SetChecked(false);
+		checkbox = (CheckBox*)toolBar->GetChild("FixedTimeStep", true);
+		if (checkbox->IsChecked() != (playFixedTimeStep > 0.0f))
+			checkbox->SetChecked(playFixedTimeStep > 0.0f);
+
 		checkbox = (CheckBox*)toolBar->GetChild("EditMove", true);
 		if (checkbox->IsChecked() != (editMode == EDIT_MOVE))
 			checkbox->SetChecked(editMode == EDIT_MOVE);
@@ -1849,6 +3084,29 @@ namespace Urho3D
 		if (checkbox->IsChecked() != (snapScaleMode == SNAP_SCALE_QUARTER))
 			checkbox->SetChecked(snapScaleMode == SNAP_SCALE_QUARTER);
 
+		checkbox = (CheckBox*)toolBar->GetChild("SnapSurface", true);
+		if (checkbox->IsChecked() != (spatialSnapMode == SPATIAL_SNAP_SURFACE))
+			checkbox->SetChecked(spatialSnapMode == SPATIAL_SNAP_SURFACE);
+		checkbox = (CheckBox*)toolBar->GetChild("SnapVertex", true);
+		if (checkbox->IsChecked() != (spatialSnapMode == SPATIAL_SNAP_VERTEX))
+			checkbox->SetChecked(spatialSnapMode == SPATIAL_SNAP_VERTEX);
+		checkbox = (CheckBox*)toolBar->GetChild("SnapBounds", true);
+		if (checkbox->IsChecked() != (spatialSnapMode == SPATIAL_SNAP_BOUNDS))
+			checkbox->SetChecked(spatialSnapMode == SPATIAL_SNAP_BOUNDS);
+
+		checkbox = (CheckBox*)toolBar->GetChild("PivotMedian", true);
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_MEDIAN))
+			checkbox->SetChecked(pivotMode == PIVOT_MEDIAN);
+		checkbox = (CheckBox*)toolBar->GetChild("PivotBoundsCenter", true);
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_BOUNDS_CENTER))
+			checkbox->SetChecked(pivotMode == PIVOT_BOUNDS_CENTER);
+		checkbox = (CheckBox*)toolBar->GetChild("PivotActive", true);
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_ACTIVE))
+			checkbox->SetChecked(pivotMode == PIVOT_ACTIVE);
+		checkbox = (CheckBox*)toolBar->GetChild("PivotIndividual", true);
+		if (checkbox->IsChecked() != (pivotMode == PIVOT_INDIVIDUAL))
+			checkbox->SetChecked(pivotMode == PIVOT_INDIVIDUAL);
+
 		checkbox = (CheckBox*)toolBar->GetChild("PickGeometries", true);
 		if (checkbox->IsChecked() != (pickMode == PICK_GEOMETRIES))
 			checkbox->SetChecked(pickMode == PICK_GEOMETRIES);
@@ -1911,6 +3169,43 @@ namespace Urho3D
 		toolBarDirty = true;
 	}
 
+	void EPScene3D::ToolBarRunUpdateStep(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		// Works as a button, the toggle is released again by UpdateToolBar
+		if (edit && edit->IsChecked())
+			StepPlayScene(input_->GetQualifierDown(QUAL_SHIFT) ? playStepCount : 1);
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarFixedTimeStep(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		playFixedTimeStep = edit->IsChecked() ? 1.0f / 60.0f : 0.0f;
+		playTimeAccumulator_ = 0.0f;
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarTimeScaleDown(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			SetPlayTimeScale(playTimeScale * 0.5f);
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarTimeScaleUp(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			SetPlayTimeScale(playTimeScale * 2.0f);
+		toolBarDirty = true;
+	}
+
 	void EPScene3D::ToolBarEditModeMove(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace Toggled;
@@ -2023,6 +3318,75 @@ namespace Urho3D
 		toolBarDirty = true;
 	}
 
+	void EPScene3D::ToolBarSnapSurface(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			spatialSnapMode = SPATIAL_SNAP_SURFACE;
+		else if (spatialSnapMode == SPATIAL_SNAP_SURFACE)
+			spatialSnapMode = SPATIAL_SNAP_NONE;
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarSnapVertex(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			spatialSnapMode = SPATIAL_SNAP_VERTEX;
+		else if (spatialSnapMode == SPATIAL_SNAP_VERTEX)
+			spatialSnapMode = SPATIAL_SNAP_NONE;
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarSnapBounds(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			spatialSnapMode = SPATIAL_SNAP_BOUNDS;
+		else if (spatialSnapMode == SPATIAL_SNAP_BOUNDS)
+			spatialSnapMode = SPATIAL_SNAP_NONE;
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarPivotMedian(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			SetPivotMode(PIVOT_MEDIAN);
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarPivotBoundsCenter(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			SetPivotMode(PIVOT_BOUNDS_CENTER);
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarPivotActive(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			SetPivotMode(PIVOT_ACTIVE);
+		toolBarDirty = true;
+	}
+
+	void EPScene3D::ToolBarPivotIndividual(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Toggled;
+		CheckBox* edit = (CheckBox*)eventData[P_ELEMENT].GetPtr();
+		if (edit && edit->IsChecked())
+			SetPivotMode(PIVOT_INDIVIDUAL);
+		toolBarDirty = true;
+	}
+
 	void EPScene3D::ToolBarPickModeGeometries(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace Toggled;
@@ -2119,6 +3483,8 @@ namespace Urho3D
 	{
 		if (grid_ != NULL)
 			grid_->SetEnabled(false);
+		if (gridAxes_ != NULL)
+			gridAxes_->SetEnabled(false);
 	}
 
 	void EPScene3D::ShowGrid()
@@ -2126,30 +3492,35 @@ namespace Urho3D
 		if (grid_ != NULL)
 		{
 			grid_->SetEnabled(true);
+			gridAxes_->SetEnabled(true);
 
-			EditorData* editorData_ = GetSubsystem<EditorData>();
-			if (editorData_->GetEditorScene()->GetComponent<Octree>() != NULL)
-				editorData_->GetEditorScene()->GetComponent<Octree>()->AddManualDrawable(grid_);
+			Octree* octree = GetRenderScene()->GetComponent<Octree>();
+			if (octree != NULL)
+			{
+				octree->AddManualDrawable(grid_);
+				octree->AddManualDrawable(gridAxes_);
+			}
 		}
 	}
 
 	void EPScene3D::StartSceneUpdate()
 	{
+		// A half loaded scene would be cloned half loaded
+		if (editorData_->GetEditorScene()->IsAsyncLoading())
+		{
+			toolBarDirty = true;
+			return;
+		}
+
+		if (!playScene_)
+			CreatePlayScene();
+
 		runUpdate = true;
+		playTimeAccumulator_ = 0.0f;
 		// Run audio playback only when scene is updating, so that audio components' time-dependent attributes stay constant when
 		// paused (similar to physics)
 		//audio.Play();
 		toolBarDirty = true;
-
-		// Save scene data for reverting if enabled
-		if (revertOnPause)
-		{
-			revertData = new XMLFile(context_);
-			XMLElement root = revertData->CreateRoot("scene");
-			editorData_->GetEditorScene()->SaveXML(root);
-		}
-		else
-			revertData = NULL;
 	}
 
 	void EPScene3D::StopSceneUpdate()
@@ -2158,95 +3529,322 @@ namespace Urho3D
 		//audio.Stop();
 		toolBarDirty = true;
 
-		// If scene should revert on update stop, load saved data now
-		if (revertOnPause && revertData.NotNull())
+		// The edited scene was never touched, reverting just drops the clone. Otherwise the played state is written back
+		// into the edited scene, so that picking, the gizmo and the inspector work on what is shown. The next start clones
+		// it again and continues from there.
+		if (!revertOnPause)
+			ApplyPlayScene();
+		DiscardPlayScene();
+	}
+
+	void EPScene3D::ApplyPlayScene()
+	{
+		if (!playScene_)
+			return;
+
+		// The clone keeps the ids of the edited scene, restoring a snapshot of it only rewrites what the play changed
+		revertData->Take(playScene_);
+		if (revertData->Restore(editorData_->GetEditorScene()))
+			sceneModified = true;
+		revertData->Clear();
+	}
+
+	Scene* EPScene3D::GetRenderScene() const
+	{
+		return playScene_ ? playScene_.Get() : editorData_->GetEditorScene();
+	}
+
+	void EPScene3D::DetachOverlays()
+	{
+		// Manual drawables belong to one octree, they are added again to the scene the views show next
+		HideGrid();
+		gizmo_->HideGizmo();
+		handleOverlay_->Hide();
+		viewsDirty_ = true;
+	}
+
+	void EPScene3D::CreatePlayScene()
+	{
+		if (!playScene_)
 		{
-			editor_->GetHierarchyWindow()->SetSuppressSceneChanges(true);
+			playScene_ = new Scene(context_);
+			// Updated by hand, so that it can be paused and stepped
+			playScene_->SetUpdateEnabled(false);
+			// Receivers are called in subscription order, subscribing before any component exists makes these run first
+			SubscribeToEvent(playScene_, E_SCENEUPDATE, HANDLER(EPScene3D, HandlePlayScenePhase));
+			SubscribeToEvent(playScene_, E_ATTRIBUTEANIMATIONUPDATE, HANDLER(EPScene3D, HandlePlayScenePhase));
+			SubscribeToEvent(playScene_, E_SCENESUBSYSTEMUPDATE, HANDLER(EPScene3D, HandlePlayScenePhase));
+			SubscribeToEvent(playScene_, E_SCENEPOSTUPDATE, HANDLER(EPScene3D, HandlePlayScenePhase));
+		}
 
-			editorData_->GetEditorScene()->Clear();
-			editorData_->GetEditorScene()->LoadXML(revertData->GetRoot());
-			CreateGrid();
-			editor_->GetHierarchyWindow()->UpdateHierarchyItem(editorData_->GetEditorScene(), true);
-			//ClearEditActions();
-			editor_->GetHierarchyWindow()->SetSuppressSceneChanges(false);
+		DetachOverlays();
+		revertData->Take(editorData_->GetEditorScene());
+		revertData->CopyTo(playScene_);
+		// Only the buffer capacity is worth keeping
+		revertData->Clear();
+
+		for (unsigned i = 0; i < views_.Size(); ++i)
+			views_[i]->SetRenderScene(playScene_);
+		// The gizmo and the handles show up again with their next update
+		if (showGrid_)
+			ShowGrid();
+	}
+
+	void EPScene3D::DiscardPlayScene()
+	{
+		if (!playScene_)
+			return;
+
+		for (unsigned i = 0; i < views_.Size(); ++i)
+			views_[i]->SetRenderScene(NULL);
+
+		DetachOverlays();
+		UnsubscribeFromEvents(playScene_);
+		playScene_.Reset();
+		if (showGrid_)
+			ShowGrid();
+		playTimeAccumulator_ = 0.0f;
+		pendingPlaySteps_ = 0;
+	}
+
+	void EPScene3D::UpdatePlayScene(float timeStep)
+	{
+		if (!playScene_)
+			return;
+
+		if (playFixedTimeStep <= 0.0f)
+		{
+			RunPlayStep(timeStep * playTimeScale);
+			return;
+		}
+
+		// The scale changes how much play time passes, the step length stays fixed
+		playTimeAccumulator_ += timeStep * playTimeScale;
+		unsigned steps = 0;
+		while (playTimeAccumulator_ >= playFixedTimeStep && steps < playMaxSteps)
+		{
+			RunPlayStep(playFixedTimeStep);
+			playTimeAccumulator_ -= playFixedTimeStep;
+			++steps;
+		}
+
+		if (playTimeAccumulator_ >= playFixedTimeStep)
+			playTimeAccumulator_ = 0.0f;
+	}
+
+	void EPScene3D::RunPlayStep(float timeStep)
+	{
+		if (!playScene_)
+			return;
+
+		for (unsigned i = 0; i < MAX_PLAY_TIMINGS; ++i)
+			playTimings_[i] = 0.0f;
+
+		playTimer_.Reset();
+		playPhaseStart_ = 0;
+		playPhase_ = -1;
+
+		playScene_->Update(timeStep);
+
+		long long end = playTimer_.GetUSec(false);
+		if (playPhase_ >= 0)
+			playTimings_[playPhase_] += (end - playPhaseStart_) / 1000.0f;
+		playTimings_[PLAY_TIMING_TOTAL] = end / 1000.0f;
+		playPhase_ = -1;
+	}
+
+	void EPScene3D::HandlePlayScenePhase(StringHash eventType, VariantMap& eventData)
+	{
+		long long now = playTimer_.GetUSec(false);
+		if (playPhase_ >= 0)
+			playTimings_[playPhase_] += (now - playPhaseStart_) / 1000.0f;
+
+		if (eventType == E_SCENEUPDATE)
+			playPhase_ = PLAY_TIMING_LOGIC;
+		else if (eventType == E_ATTRIBUTEANIMATIONUPDATE)
+			playPhase_ = PLAY_TIMING_ANIMATION;
+		else if (eventType == E_SCENESUBSYSTEMUPDATE)
+			playPhase_ = PLAY_TIMING_PHYSICS;
+		else
+			playPhase_ = PLAY_TIMING_POSTUPDATE;
+		playPhaseStart_ = now;
+	}
+
+	void EPScene3D::StepPlayScene(unsigned count /*= 1*/)
+	{
+		if (editorData_->GetEditorScene()->IsAsyncLoading())
+			return;
+
+		if (runUpdate)
+		{
+			runUpdate = false;
+			toolBarDirty = true;
 		}
 
-		revertData = NULL;
+		if (!playScene_)
+			CreatePlayScene();
+
+		pendingPlaySteps_ += count;
+	}
+
+	void EPScene3D::SetPlayTimeScale(float scale)
+	{
+		playTimeScale = Clamp(scale, 1.0f / 16.0f, 16.0f);
 	}
 
 	void EPScene3D::CreateGrid()
 	{
 		ResourceCache* cache = GetSubsystem<ResourceCache>();
+		bool updateGridGeometry = false;
 		if (!gridNode_)
 		{
+			Material* gridMaterial = cache->GetResource<Material>("Materials/VColUnlit.xml");
+			if (gridMaterial != NULL)
+				gridSubdivisionMaterial_ = gridMaterial->Clone();
+
 			gridNode_ = new Node(context_);
 			grid_ = gridNode_->CreateComponent<CustomGeometry>();
-			grid_->SetNumGeometries(1);
-			grid_->SetMaterial(cache->GetResource<Material>("Materials/VColUnlit.xml"));
+			grid_->SetNumGeometries(2);
+			grid_->SetMaterial(0, gridMaterial);
+			grid_->SetMaterial(1, gridSubdivisionMaterial_);
 			grid_->SetViewMask(0x80000000); // Editor raycasts use viewmask 0x7fffffff
 			grid_->SetOccludee(false);
+
+			gridAxesNode_ = new Node(context_);
+			gridAxes_ = gridAxesNode_->CreateComponent<CustomGeometry>();
+			gridAxes_->SetNumGeometries(1);
+			gridAxes_->SetMaterial(gridMaterial);
+			gridAxes_->SetViewMask(0x80000000);
+			gridAxes_->SetOccludee(false);
+
+			updateGridGeometry = true;
 		}
-		UpdateGrid();
+		// The geometry is built only once, a new scene just needs the manual drawables readded to its octree
+		UpdateGrid(updateGridGeometry);
 	}
 
 	void EPScene3D::UpdateGrid(bool updateGridGeometry /*= true*/)
 	{
 		showGrid_ ? ShowGrid() : HideGrid();
-		gridNode_->SetScale(Vector3(8.0f, 8.0f, 8.0f));
+		// Force the grid transform to be reapplied
+		gridLevel_ = M_MAX_INT;
+		gridFade_ = -1.0f;
 
 		if (!updateGridGeometry)
 		{
 		    return;
 		}
 
-		unsigned int size = (unsigned int)(floor(8.0f / 2.0f) * 2.0f);
-		float halfSizeScaled = size / 2.0f;
-		float scale = 1.0f;
-		unsigned int subdivisionSize = (unsigned int)(pow(2.0f, 3.0f));
+		// Grid lines in local space, one unit per major cell. The node scale selects the world size of the current grid level.
+		unsigned int size = gridSize * gridSubdivisions;
+		float halfSize = gridSize / 2.0f;
+		float step = 1.0f / gridSubdivisions;
 
-		if (subdivisionSize > 0)
+		for (unsigned int geometry = 0; geometry < 2; ++geometry)
 		{
-			size *= subdivisionSize;
-			scale /= subdivisionSize;
+			// Geometry 0 holds the major lines, geometry 1 the subdivision lines
+			grid_->BeginGeometry(geometry, LINE_LIST);
+			float lineOffset = -halfSize;
+			for (unsigned int i = 0; i <= size; ++i)
+			{
+				bool lineSubdiv = (i % gridSubdivisions) != 0;
+				if (lineSubdiv == (geometry == 1))
+				{
+					if (!grid2DMode_)
+					{
+						grid_->DefineVertex(Vector3(lineOffset, 0.0, halfSize));
+						grid_->DefineColor(gridColor);
+						grid_->DefineVertex(Vector3(lineOffset, 0.0, -halfSize));
+						grid_->DefineColor(gridColor);
+
+						grid_->DefineVertex(Vector3(-halfSize, 0.0, lineOffset));
+						grid_->DefineColor(gridColor);
+						grid_->DefineVertex(Vector3(halfSize, 0.0, lineOffset));
+						grid_->DefineColor(gridColor);
+					}
+					else
+					{
+						grid_->DefineVertex(Vector3(lineOffset, halfSize, 0.0));
+						grid_->DefineColor(gridColor);
+						grid_->DefineVertex(Vector3(lineOffset, -halfSize, 0.0));
+						grid_->DefineColor(gridColor);
+
+						grid_->DefineVertex(Vector3(-halfSize, lineOffset, 0.0));
+						grid_->DefineColor(gridColor);
+						grid_->DefineVertex(Vector3(halfSize, lineOffset, 0.0));
+						grid_->DefineColor(gridColor);
+					}
+				}
+				lineOffset += step;
+			}
 		}
+		grid_->Commit();
 
-		unsigned int halfSize = size / 2;
-
-		grid_->BeginGeometry(0, LINE_LIST);
-		float lineOffset = -halfSizeScaled;
-		for (unsigned int i = 0; i <= size; ++i)
+		gridAxes_->BeginGeometry(0, LINE_LIST);
+		gridAxes_->DefineVertex(Vector3(-1.0f, 0.0f, 0.0f));
+		gridAxes_->DefineColor(gridXColor);
+		gridAxes_->DefineVertex(Vector3(1.0f, 0.0f, 0.0f));
+		gridAxes_->DefineColor(gridXColor);
+		if (!grid2DMode_)
+		{
+			gridAxes_->DefineVertex(Vector3(0.0f, 0.0f, -1.0f));
+			gridAxes_->DefineColor(gridZColor);
+			gridAxes_->DefineVertex(Vector3(0.0f, 0.0f, 1.0f));
+			gridAxes_->DefineColor(gridZColor);
+		}
+		else
 		{
-			bool lineCenter = i == halfSize;
-			bool lineSubdiv = !Equals(float(i% subdivisionSize), 0.0f);
+			gridAxes_->DefineVertex(Vector3(0.0f, -1.0f, 0.0f));
+			gridAxes_->DefineColor(gridYColor);
+			gridAxes_->DefineVertex(Vector3(0.0f, 1.0f, 0.0f));
+			gridAxes_->DefineColor(gridYColor);
+		}
+		gridAxes_->Commit();
+	}
 
-			if (!grid2DMode_)
-			{
-				grid_->DefineVertex(Vector3(lineOffset, 0.0, halfSizeScaled));
-				grid_->DefineColor(lineCenter ? gridZColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-				grid_->DefineVertex(Vector3(lineOffset, 0.0, -halfSizeScaled));
-				grid_->DefineColor(lineCenter ? gridZColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-
-				grid_->DefineVertex(Vector3(-halfSizeScaled, 0.0, lineOffset));
-				grid_->DefineColor(lineCenter ? gridXColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-				grid_->DefineVertex(Vector3(halfSizeScaled, 0.0, lineOffset));
-				grid_->DefineColor(lineCenter ? gridXColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-			}
-			else
-			{
-				grid_->DefineVertex(Vector3(lineOffset, halfSizeScaled, 0.0));
-				grid_->DefineColor(lineCenter ? gridYColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-				grid_->DefineVertex(Vector3(lineOffset, -halfSizeScaled, 0.0));
-				grid_->DefineColor(lineCenter ? gridYColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-
-				grid_->DefineVertex(Vector3(-halfSizeScaled, lineOffset, 0.0));
-				grid_->DefineColor(lineCenter ? gridXColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-				grid_->DefineVertex(Vector3(halfSizeScaled, lineOffset, 0.0));
-				grid_->DefineColor(lineCenter ? gridXColor : (lineSubdiv ? gridSubdivisionColor : gridColor));
-			}
+	void EPScene3D::UpdateGridTransform()
+	{
+		if (!showGrid_ || gridNode_ == NULL)
+			return;
+
+		Vector3 cameraPos = cameraNode_->GetWorldPosition();
+		float distance;
+		if (camera_->IsOrthographic())
+			distance = camera_->GetOrthoSize() / camera_->GetZoom();
+		else
+			distance = Abs(grid2DMode_ ? cameraPos.z_ : cameraPos.y_);
+
+		// Levels are gridSubdivisions apart, so the major lines of one level become the subdivision lines of the next one
+		float levelFactor = (float)gridSubdivisions;
+		float level = log(Max(distance, 0.01f) / gridScale) / log(levelFactor);
+		int gridLevel = (int)floor(level);
+		float spacing = gridScale * pow(levelFactor, (float)gridLevel);
+
+		// Snap to the major lines so the grid seems to stay in place while it follows the camera
+		Vector3 position;
+		position.x_ = floor(cameraPos.x_ / spacing + 0.5f) * spacing;
+		if (!grid2DMode_)
+			position.z_ = floor(cameraPos.z_ / spacing + 0.5f) * spacing;
+		else
+			position.y_ = floor(cameraPos.y_ / spacing + 0.5f) * spacing;
 
-			lineOffset += scale;
+		if (gridLevel != gridLevel_ || position != gridPosition_)
+		{
+			gridNode_->SetTransform(position, Quaternion::IDENTITY, spacing);
+			gridAxesNode_->SetScale(spacing * gridSize / 2.0f);
+			gridLevel_ = gridLevel;
+			gridPosition_ = position;
+			viewsDirty_ = true;
+		}
+
+		// Fade the subdivisions out towards the next grid level
+		float fade = 1.0f - (level - gridLevel);
+		if (gridSubdivisionMaterial_ != NULL && Abs(fade - gridFade_) > 1.0f / 255.0f)
+		{
+			gridSubdivisionMaterial_->SetShaderParameter("MatDiffColor", Color(fade, fade, fade));
+			gridFade_ = fade;
+			viewsDirty_ = true;
 		}
-		grid_->Commit();
 	}
 
 	EPScene3DView::EPScene3DView(Context* context) : BorderImage(context),
@@ -2254,7 +3852,13 @@ namespace Urho3D
 		rttFormat_(Graphics::GetRGBFormat()),
 		autoUpdate_(true),
 		cameraYaw_(0.0f),
-		cameraPitch_(0.0f)
+		cameraPitch_(0.0f),
+		lastZoom_(0.0f),
+		lastOrthoSize_(0.0f),
+		lastOrthographic_(false),
+		defaultPosition_(0.0f, 5.0f, -10.0f),
+		defaultRotation_(Quaternion(Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, -5.0f, 10.0f))),
+		defaultOrthographic_(false)
 	{
 		SetEnabled(true);
 		bringToFront_ = true;
@@ -2363,6 +3967,12 @@ namespace Urho3D
 		}
 	}
 
+	void EPScene3DView::SetRenderScene(Scene* scene)
+	{
+		viewport_->SetScene(scene ? scene : scene_.Get());
+		QueueUpdate();
+	}
+
 	Scene* EPScene3DView::GetScene() const
 	{
 		return scene_;
@@ -2375,13 +3985,21 @@ namespace Urho3D
 
 	void EPScene3DView::ResetCamera()
 	{
-		cameraNode_->SetPosition(Vector3(0.0f, 5.0f, -10.0f));
-		// Look at the origin so user can see the scene.
-		cameraNode_->SetRotation(Quaternion(Vector3(0.0f, 0.0f, 1.0f), -cameraNode_->GetPosition()));
+		// By default look at the origin so user can see the scene.
+		cameraNode_->SetPosition(defaultPosition_);
+		cameraNode_->SetRotation(defaultRotation_);
+		camera_->SetOrthographic(defaultOrthographic_);
 		ReacquireCameraYawPitch();
 		//	UpdateSettingsUI();
 	}
 
+	void EPScene3DView::SetDefaultCamera(const Vector3& position, const Quaternion& rotation, bool orthographic)
+	{
+		defaultPosition_ = position;
+		defaultRotation_ = rotation;
+		defaultOrthographic_ = orthographic;
+	}
+
 	void EPScene3DView::ResetCamera(StringHash eventType, VariantMap& eventData)
 	{
 		ResetCamera();
@@ -2600,6 +4218,18 @@ namespace Urho3D
 
 	void EPScene3DView::Update(float timeStep)
 	{
+		// Nothing to render or display if the camera did not change
+		const Matrix3x4& cameraTransform = cameraNode_->GetWorldTransform();
+		if (cameraTransform == lastCameraTransform_ && camera_->GetZoom() == lastZoom_ &&
+			camera_->GetOrthoSize() == lastOrthoSize_ && camera_->IsOrthographic() == lastOrthographic_)
+			return;
+
+		lastCameraTransform_ = cameraTransform;
+		lastZoom_ = camera_->GetZoom();
+		lastOrthoSize_ = camera_->GetOrthoSize();
+		lastOrthographic_ = camera_->IsOrthographic();
+		QueueUpdate();
+
 		Vector3 cameraPos = cameraNode_->GetPosition();
 		String xText(cameraPos.x_);
 		String yText(cameraPos.y_);
@@ -6,6 +6,10 @@
 #include "UIGlobals.h"
 #include "../UI/UIElement.h"
 #include "../Scene/Node.h"
+#include "../Math/BoundingBox.h"
+#include "../Core/Timer.h"
+#include "SpatialSnap.h"
+#include "SelectionSets.h"
 
 namespace Urho3D
 {
@@ -30,6 +34,43 @@ namespace Urho3D
 		AXIS_LOCAL
 	};
 
+	/// phases of a play scene step, each is timed separately
+	enum PlayTiming
+	{
+		/// scene update event: logic and script components
+		PLAY_TIMING_LOGIC = 0,
+		/// attribute animations
+		PLAY_TIMING_ANIMATION,
+		/// scene subsystem update: physics, including fixed update logic
+		PLAY_TIMING_PHYSICS,
+		/// scene post update: animation controllers and post update logic
+		PLAY_TIMING_POSTUPDATE,
+		/// the whole step
+		PLAY_TIMING_TOTAL,
+		MAX_PLAY_TIMINGS
+	};
+
+	/// the value is the number of views
+	enum ViewportLayout
+	{
+		VIEWPORT_SINGLE = 1,
+		VIEWPORT_SPLIT = 2,
+		VIEWPORT_QUAD = 4
+	};
+
+	/// point the selection rotates around
+	enum PivotMode
+	{
+		/// average of the node positions
+		PIVOT_MEDIAN = 0,
+		/// center of the selection bounds
+		PIVOT_BOUNDS_CENTER,
+		/// position of the first edited node
+		PIVOT_ACTIVE,
+		/// every node rotates around its own position
+		PIVOT_INDIVIDUAL
+	};
+
 	enum SnapScaleMode
 	{
 		SNAP_SCALE_FULL = 0,
@@ -44,6 +85,7 @@ namespace Urho3D
 	class Scene;
 	class CustomGeometry;
 	class Texture2D;
+	class Material;
 	class Viewport;
 	class EditorData;
 	class EditorView;
@@ -65,9 +107,28 @@ namespace Urho3D
 	class File;
 	class Editor;
 	class Button;
+	class SceneSnapshot;
+	class SceneSaveThread;
+	class PrefabCache;
 
 	class EPScene3D;
 	class GizmoScene3D;
+	class HandleOverlay;
+
+	/// cached debug draw list of a selected node subtree, rebuilt only when the subtree changes.
+	struct DebugDrawCache
+	{
+		/// selected root node
+		WeakPtr<Node> node_;
+		/// components of the subtree that draw debug geometry
+		Vector<WeakPtr<Component> > components_;
+		/// lights, zones and collision shapes of the subtree, drawn by the handle overlay
+		Vector<WeakPtr<Component> > handles_;
+		/// combined world bounds of the subtree drawables, drawn instead of the components when over the draw cap
+		BoundingBox bounds_;
+		/// draw only the node axes and the combined bounds
+		bool lod_;
+	};
 
 	class EPScene3DView : public BorderImage
 	{
@@ -111,6 +172,8 @@ namespace Urho3D
 		void SetAutoUpdate(bool enable);
 		/// Queue manual update on the render texture.
 		void QueueUpdate();
+		/// render another scene with this view's camera, e.g. the play scene. NULL renders the view's own scene again.
+		void SetRenderScene(Scene* scene);
 
 		/// Return render texture pixel format.
 		unsigned GetFormat() const { return rttFormat_; }
@@ -132,6 +195,8 @@ namespace Urho3D
 		float	GetPitch() const { return cameraPitch_; }
 
 		void ResetCamera();
+		/// set the camera placement ResetCamera() returns to
+		void SetDefaultCamera(const Vector3& position, const Quaternion& rotation, bool orthographic);
 		void ReacquireCameraYawPitch();
 		void CreateViewportContextUI(XMLFile* uiStyle, XMLFile* iconStyle_);
 	protected:
@@ -176,6 +241,15 @@ namespace Urho3D
 		unsigned rttFormat_;
 		/// Render texture auto update mode.
 		bool autoUpdate_;
+		/// camera state of the last queued render, in manual update mode the view renders again only when it changes
+		Matrix3x4 lastCameraTransform_;
+		float lastZoom_;
+		float lastOrthoSize_;
+		bool lastOrthographic_;
+		/// ResetCamera() placement
+		Vector3 defaultPosition_;
+		Quaternion defaultRotation_;
+		bool defaultOrthographic_;
 		/// ui stuff
 		SharedPtr<UIElement>statusBar;
 		SharedPtr<Text> cameraPosText;
@@ -211,6 +285,8 @@ namespace Urho3D
 		virtual UIElement*	GetMainScreen() ;
 		virtual void		SetVisible(bool visible) ;
 		virtual void		Update(float timeStep) ;
+		/// busy while the scene runs, loads or saves
+		virtual bool		IsBusy() ;
 
 
         /** Original code
@@ -234,36 +310,110 @@ namespace Urho3D
 		void ResetCamera();
 		void ReacquireCameraYawPitch();
 		void UpdateViewParameters();
+		/// split the main screen into 1, 2 or 4 views of the editor scene
+		void SetViewportLayout(ViewportLayout layout);
+		ViewportLayout GetViewportLayout() const { return viewportLayout_; }
+		/// make the view the target of camera input, picking and the gizmo
+		void SetActiveView(EPScene3DView* view);
+		/// render all views once, views only render on their own when their camera moves
+		void QueueViewUpdates();
+		/// store the active camera in bookmark slot 0-8, bookmarks are saved with the scene
+		void SetCameraBookmark(unsigned index);
+		/// fly the active camera to the bookmark, returns false if the slot is empty
+		bool FlyToCameraBookmark(unsigned index);
+		/// animate the active camera to the transform, resources in the destination view are loaded in the background meanwhile
+		void FlyTo(const Vector3& position, const Quaternion& rotation);
+		bool IsFlying() const { return flyCameraNode_ != NULL; }
+		/// fly the active camera to frame the selection, keeps the view direction
+		bool FocusSelection();
+		/// combined world bounds of the selection from the drawable bounds, the node positions where there are none
+		BoundingBox GetSelectionBounds();
+		/// store the selected nodes and components as a named set of the scene
+		void StoreSelectionSet(const String& name);
+		/// select the set, returns false if there is no such set
+		bool SelectSelectionSet(const String& name);
+		/// select the nodes of the components matching the saved query, returns false if there is no such query
+		bool SelectQuery(const String& name);
+		void SelectQuery(const SelectionQuery& query);
+		SelectionSets* GetSelectionSets() const { return selectionSets_; }
 		// grid
 		void HideGrid();
 		void ShowGrid();
 		// scene update handling
+		/// run the play scene, it is cloned from the edited scene if there is none yet
 		void StartSceneUpdate();
+		/// pause the play scene and discard it, without revertOnPause its state is applied to the edited scene first
 		void StopSceneUpdate();
+		/// discard the play scene, the views show the edited scene again
+		void DiscardPlayScene();
+		/// write the state of the play scene into the edited scene
+		void ApplyPlayScene();
+		Scene* GetPlayScene() const { return playScene_; }
+		/// scene shown in the views: the play scene while there is one, otherwise the edited scene
+		Scene* GetRenderScene() const;
+		/// pause the play scene and advance it by count steps of playFixedTimeStep, or 1/60 s without a fixed step
+		void StepPlayScene(unsigned count = 1);
+		/// scale the play scene time, clamped to 1/16-16
+		void SetPlayTimeScale(float scale);
+		/// milliseconds the phase took in the last step
+		float GetPlayTiming(PlayTiming phase) const { return playTimings_[phase]; }
 	protected:
 		void Start();
 		void CreateMiniToolBarUI();
 		void CreateToolBarUI();
 
+		EPScene3DView* CreateView(unsigned index);
+		void LayoutViews();
 		void CreateStatsBar();
 		void SetupStatsBarText(Text* text, Font* font, int x, int y, HorizontalAlignment hAlign, VerticalAlignment vAlign);
 		void UpdateStats(float timeStep);
+		/// set the text only if the formatted stats differ from the displayed ones, cache keeps its capacity
+		void SetStatsText(Text* text, String& cache, const char* stats);
+		void UpdateCameraFlight(float timeStep);
+		/// queue background loading of resources used by the drawables inside the view from position and rotation. Only
+		/// resources not loaded yet are found, e.g. while the scene is loading in the background.
+		void PrefetchView(const Vector3& position, const Quaternion& rotation);
+		/// append the frame times of the top level profiler blocks
+		int FormatProfilerStats(char* buffer, int size);
 		void SetFillMode(FillMode fM_);
 
 		Vector3 SelectedNodesCenterPoint();
-		void	DrawNodeDebug(Node* node, DebugRenderer* debug, bool drawNode = true);
+		/// debug draw the cached selection subtrees
+		void	DrawSelectionDebug(DebugRenderer* debug);
+		/// rebuild the debug draw cache if the scene hierarchy changed, selection changes patch it in HandleEditorSelectionChanged
+		void	UpdateDebugDrawCache();
+		void	FillDebugDrawCache(Node* node, DebugDrawCache& cache);
+		void	CollectNodeDebug(Node* node, DebugDrawCache& cache);
+		void	UpdateDebugDrawBounds(DebugDrawCache& cache);
 		void	MakeBackup(const String& fileName);
 		void	RemoveBackup(bool success, const String& fileName);
 
 		/// edit nodes
 		bool MoveNodes(Vector3 adjust);
+		/// offset that snaps the first edited node to the scene after it was moved by adjust
+		Vector3 GetSpatialSnapOffset(const Vector3& adjust);
 		bool RotateNodes(Vector3 adjust);
 		bool ScaleNodes(Vector3 adjust);
+		/// pivot of the edited nodes for the pivot mode, cached until the selection changes or InvalidatePivot() is called
+		const Vector3& GetPivot();
+		/// rotation of the gizmo axes: identity in world mode, the first edited node's rotation in local mode
+		Quaternion GetGizmoRotation();
+		/// edited nodes without those that have an edited ancestor, they follow it already. Cached like the pivot.
+		const PODVector<Node*>& GetTransformRoots();
+		/// true if the scene itself is edited, its transform must not change
+		bool IsSceneEdited();
+		void InvalidatePivot() { pivotValid_ = false; }
+		void SetPivotMode(PivotMode mode);
+
+		/// recompute the pivot and the transform roots if the edited nodes changed
+		void UpdatePivotCache();
 
 		/// Picking
 		void ViewRaycast(bool mouseClick);
 		void SelectComponent(Component* component, bool multiselect);
 		void SelectNode(Node* node, bool multiselect);
+		/// replace the selection with the nodes and components in one hierarchy list update
+		void SelectObjects(const PODVector<Node*>& nodes, const PODVector<Component*>& components);
 
 		/// mouse handling
 		void SetMouseMode(bool enable);
@@ -275,6 +425,8 @@ namespace Urho3D
 		void ViewMouseClick(StringHash eventType, VariantMap& eventData);
 		void ViewMouseMove(StringHash eventType, VariantMap& eventData);
 		void ViewMouseClickEnd(StringHash eventType, VariantMap& eventData);
+		/// input that may edit the scene outside the views, marks them for rendering
+		void HandleViewInput(StringHash eventType, VariantMap& eventData);
 		void HandleBeginViewUpdate(StringHash eventType, VariantMap& eventData);
 		void HandleEndViewUpdate(StringHash eventType, VariantMap& eventData);
 		void HandleBeginViewRender(StringHash eventType, VariantMap& eventData);
@@ -285,6 +437,12 @@ namespace Urho3D
 		void HandleMenuBarAction(StringHash eventType, VariantMap& eventData);
 		/// messageBox
 		void HandleMessageAcknowledgement(StringHash eventType, VariantMap& eventData);
+		/// scene hierarchy changes, invalidates cached debug geometry
+		void HandleSceneChanged(StringHash eventType, VariantMap& eventData);
+		/// an attribute was edited in the inspector
+		void HandleAttributeEdited(StringHash eventType, VariantMap& eventData);
+		/// patch the debug draw cache with the selected and deselected nodes, the edit nodes follow the selection
+		void HandleEditorSelectionChanged(StringHash eventType, VariantMap& eventData);
 
 		// Menu Bar actions
 		/// create new scene, because we use only one scene reset it ...
@@ -294,11 +452,42 @@ namespace Urho3D
 		void HandleLoadNodeFile(StringHash eventType, VariantMap& eventData);
 		void HandleSaveNodeFile(StringHash eventType, VariantMap& eventData);
 
+		/// starts loading the scene in the background, returns false if loading could not be started.
 		bool LoadScene(const String& fileName);
+		/// finish the background scene load
+		void HandleAsyncLoadProgress(StringHash eventType, VariantMap& eventData);
+		void HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData);
+		/// abort a background load of the edited scene, nothing happens if there is none
+		void StopSceneLoading();
+		/// add the scene children loaded since the last call to the hierarchy
+		void StreamHierarchy();
+		void CreateLoadingBar();
+		void UpdateLoadingBar(float progress, int loadedNodes, int totalNodes, int loadedResources, int totalResources);
+		/// captures the scene and writes it in the background, returns false if the save could not be started.
 		bool SaveScene(const String& fileName);
+		/// write the scene next to its file without touching the modified state
+		bool AutosaveScene();
+		String GetAutosaveFileName() const;
+		/// check the background save and report a failure
+		void UpdateSceneSave(float timeStep);
+		/// clone the edited scene into the play scene and show it in all views
+		void CreatePlayScene();
+		/// take the grid, the gizmo and the handle overlay out of the octree of the shown scene
+		void DetachOverlays();
+		/// advance the play scene by the frame time or in fixed steps
+		void UpdatePlayScene(float timeStep);
+		/// run one timed step of the play scene
+		void RunPlayStep(float timeStep);
+		/// mark the start of a step phase, subscribed to the play scene before its components so it runs first
+		void HandlePlayScenePhase(StringHash eventType, VariantMap& eventData);
 		Node* LoadNode(const String& fileName, Node* parent = NULL);
 		bool SaveNode(const String& fileName);
-		Node* InstantiateNodeFromFile(File* file, const Vector3& position, const Quaternion& rotation, float scaleMod = 1.0f, Node* parent = NULL, CreateMode mode = REPLICATED);
+		/// instantiate through the prefab cache, the file is parsed once and reused until it changes on disk.
+		Node* InstantiateNodeFromFile(const String& fileName, const Vector3& position, const Quaternion& rotation, float scaleMod = 1.0f, Node* parent = NULL, CreateMode mode = REPLICATED);
+		/// instantiate one copy per world transform with a single hierarchy update. Returns the number of nodes created.
+		unsigned InstantiateNodesFromFile(const String& fileName, const PODVector<Matrix3x4>& transforms, PODVector<Node*>& newNodes, Node* parent = NULL, CreateMode mode = REPLICATED);
+		/// with surface snapping move a new node up or down so that its bounds bottom is at height
+		void AlignToSurface(Node* node, float height);
 
 		Node* CreateNode(CreateMode mode);
 		void CreateComponent(const String& componentType);
@@ -315,6 +504,10 @@ namespace Urho3D
 		void ToolBarRunUpdatePlay(StringHash eventType, VariantMap& eventData);
 		void ToolBarRunUpdatePause(StringHash eventType, VariantMap& eventData);
 		void ToolBarRevertOnPause(StringHash eventType, VariantMap& eventData);
+		void ToolBarRunUpdateStep(StringHash eventType, VariantMap& eventData);
+		void ToolBarFixedTimeStep(StringHash eventType, VariantMap& eventData);
+		void ToolBarTimeScaleDown(StringHash eventType, VariantMap& eventData);
+		void ToolBarTimeScaleUp(StringHash eventType, VariantMap& eventData);
 		void ToolBarEditModeMove(StringHash eventType, VariantMap& eventData);
 		void ToolBarEditModeRotate(StringHash eventType, VariantMap& eventData);
 		void ToolBarEditModeScale(StringHash eventType, VariantMap& eventData);
@@ -326,6 +519,13 @@ namespace Urho3D
 		void ToolBarScaleSnap(StringHash eventType, VariantMap& eventData);
 		void ToolBarSnapScaleModeHalf(StringHash eventType, VariantMap& eventData);
 		void ToolBarSnapScaleModeQuarter(StringHash eventType, VariantMap& eventData);
+		void ToolBarSnapSurface(StringHash eventType, VariantMap& eventData);
+		void ToolBarSnapVertex(StringHash eventType, VariantMap& eventData);
+		void ToolBarSnapBounds(StringHash eventType, VariantMap& eventData);
+		void ToolBarPivotMedian(StringHash eventType, VariantMap& eventData);
+		void ToolBarPivotBoundsCenter(StringHash eventType, VariantMap& eventData);
+		void ToolBarPivotActive(StringHash eventType, VariantMap& eventData);
+		void ToolBarPivotIndividual(StringHash eventType, VariantMap& eventData);
 		void ToolBarPickModeGeometries(StringHash eventType, VariantMap& eventData);
 		void ToolBarPickModeLights(StringHash eventType, VariantMap& eventData);
 		void ToolBarPickModeZones(StringHash eventType, VariantMap& eventData);
@@ -337,6 +537,10 @@ namespace Urho3D
 
 		SharedPtr<UIElement>		window_;
 		SharedPtr<EPScene3DView>	activeView;
+		Vector<SharedPtr<EPScene3DView> > views_;
+		ViewportLayout viewportLayout_;
+		/// something visible in all views changed since the last frame
+		bool viewsDirty_;
 		SharedPtr<Node>				cameraNode_;
 		SharedPtr<Camera>			camera_;
 
@@ -363,7 +567,36 @@ namespace Urho3D
 		bool	runUpdate;
 		bool    revertOnPause;
 
-		SharedPtr<XMLFile> revertData;
+		/// camera flight
+		WeakPtr<Node> flyCameraNode_;
+		Vector3 flyStartPosition_;
+		Vector3 flyTargetPosition_;
+		Quaternion flyStartRotation_;
+		Quaternion flyTargetRotation_;
+		float flyTime_;
+		/// seconds a flight takes
+		float flyDuration;
+
+		/// attribute buffers the play scene is cloned from, the buffer is reused between runs
+		SharedPtr<SceneSnapshot> revertData;
+		/// clone of the edited scene that runs while playing, the edited scene is never updated
+		SharedPtr<Scene> playScene_;
+		/// update the play scene in fixed steps of this length, 0 uses the frame time step
+		float playFixedTimeStep;
+		/// most fixed steps taken in one frame, the remainder is dropped so a slow frame can not snowball
+		unsigned playMaxSteps;
+		float playTimeAccumulator_;
+		/// play scene time multiplier
+		float playTimeScale;
+		/// steps taken by the step button with shift held
+		unsigned playStepCount;
+		/// steps requested while paused, run on the next update
+		unsigned pendingPlaySteps_;
+		/// step phase timing
+		HiresTimer playTimer_;
+		long long playPhaseStart_;
+		int playPhase_;
+		float playTimings_[MAX_PLAY_TIMINGS];
 
 		///camera handling
 		float	cameraBaseSpeed;
@@ -386,10 +619,35 @@ namespace Urho3D
 		bool	moveSnap;
 		bool	rotateSnap;
 		bool	scaleSnap;
+		/// snapping to other objects while moving
+		SpatialSnapMode spatialSnapMode;
+		/// how far vertex and bounds snapping reach
+		float	spatialSnapDistance;
+		SharedPtr<SpatialSnap> spatialSnap_;
+		/// named selection sets and saved queries of the edited scene
+		SharedPtr<SelectionSets> selectionSets_;
+		/// where the snapped node would be without snapping, so a drag can pull it out of a snap again
+		WeakPtr<Node> snapLeadNode_;
+		Vector3 snapFreePosition_;
+		Vector3 snapLastPosition_;
+		/// rotation pivot
+		PivotMode pivotMode;
+		Vector3 pivot_;
+		bool pivotValid_;
+		bool pivotContainsScene_;
+		/// the edited nodes changed since the transform roots were collected
+		bool pivotNodesDirty_;
+		PODVector<Node*> transformRoots_;
 		/// debug handling
 		bool	renderingDebug;
 		bool	physicsDebug;
 		bool	octreeDebug;
+		/// selection debug geometry cache by node ID
+		HashMap<unsigned, DebugDrawCache> debugDrawCache_;
+		bool	debugDrawDirty_;
+		bool	debugDrawBoundsDirty_;
+		/// max components of the selection that draw their full debug geometry per frame, the rest draw bounds only
+		unsigned debugDrawMaxComponents;
 
 		/// mouse pick handling
 		int		pickMode;
@@ -401,11 +659,44 @@ namespace Urho3D
 
 		/// scene handling
 		bool sceneModified;
+		/// file the scene was loaded from or last saved to
+		String sceneFileName;
+		/// seconds between autosaves of a modified scene, 0 disables autosave
+		float autosaveInterval;
+		float autosaveTimer_;
+		/// writes scene snapshots to disk off the main thread
+		SharedPtr<SceneSaveThread> saveThread_;
+		/// parsed node files for instantiation
+		SharedPtr<PrefabCache> prefabCache_;
 		String instantiateFileName;
 		CreateMode instantiateMode;
+		/// number of scene children already added to the hierarchy during a background load
+		unsigned loadingHierarchyCount_;
 		/// ui stuff
+		SharedPtr<BorderImage> loadingBar_;
+		SharedPtr<BorderImage> loadingBarFill_;
+		SharedPtr<Text> loadingText_;
 		SharedPtr<Text> editorModeText;
 		SharedPtr<Text> renderStatsText;
+		SharedPtr<Text> frameStatsText;
+		/// time scale, step length and phase timings of the play scene
+		SharedPtr<Text> playStatsText;
+		/// seconds between stats bar updates, 0 updates every frame
+		float statsUpdateInterval;
+		float statsTimer_;
+		/// displayed stats, preallocated and reused
+		String editorModeString_;
+		String renderStatsString_;
+		String frameStatsString_;
+		String playStatsString_;
+		/// last edit modes and render counters, the texts are only formatted when these change
+		int statsModes_;
+		unsigned statsCounters_[5];
+		/// frame times of the last statsFrameHistory frames in a ring buffer, and a scratch buffer to sort them
+		PODVector<float> frameTimes_;
+		PODVector<float> sortedFrameTimes_;
+		unsigned frameTimeIndex_;
+		unsigned statsFrameHistory;
 		SharedPtr<Menu>	sceneMenu_;
 		SharedPtr<Menu>	createMenu_;
 		/// cached mini tool bar buttons, to set visibility
@@ -417,19 +708,37 @@ namespace Urho3D
         bool toolBarDirty;
 		/// gizmo
 		SharedPtr<GizmoScene3D> gizmo_;
+		/// handles of the selected lights, zones and collision shapes
+		SharedPtr<HandleOverlay> handleOverlay_;
 
 		//////////////////////////////////////////////////////////////////////////
 		/// Grid handling \todo put it into a component or object ...
 
 		void CreateGrid();
 		void UpdateGrid(bool updateGridGeometry = true);
+		/// follow the camera with the grid and fade the subdivisions by camera distance, only touches the grid transform
+		void UpdateGridTransform();
 
 		SharedPtr<Node>				gridNode_;
 		SharedPtr<CustomGeometry>	grid_;
+		/// world axes, kept at the origin while the grid follows the camera
+		SharedPtr<Node>				gridAxesNode_;
+		SharedPtr<CustomGeometry>	gridAxes_;
+		/// subdivision lines material, its diffuse color fades the subdivisions
+		SharedPtr<Material>			gridSubdivisionMaterial_;
 		bool	showGrid_;
 		bool	grid2DMode_;
+		/// number of major grid cells
+		unsigned gridSize;
+		/// subdivision lines per major cell, also the spacing factor between two grid levels
+		unsigned gridSubdivisions;
+		/// world size of a major grid cell at level 0
+		float	gridScale;
+		/// last applied grid level, position and subdivision fade
+		int		gridLevel_;
+		Vector3	gridPosition_;
+		float	gridFade_;
 		Color gridColor;
-		Color gridSubdivisionColor;
 		Color gridXColor;
 		Color gridYColor;
 		Color gridZColor;
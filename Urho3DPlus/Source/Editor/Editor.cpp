@@ -31,6 +31,7 @@
 
 #include "Editor/EditorSelection.h"
 #include "UI/HierarchyWindow.h"
+#include "UI/SceneStatsWindow.h"
 #include "UI/AttributeInspector.h"
 #include "UI/MenuBarUI.h"
 #include "UI/ToolBarUI.h"
@@ -54,6 +55,10 @@
 #include "ProjectManager.h"
 #include "../IO/Log.h"
 #include "ResourceBrowser.h"
+#include "../Engine/Engine.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Graphics/GraphicsEvents.h"
+#include "SDL/SDL_events.h"
 
 namespace Urho3D
 {
@@ -69,13 +74,24 @@ namespace Urho3D
 
 	Editor::~Editor()
 	{
+		Engine* engine = GetSubsystem<Engine>();
+		if (engine)
+			engine->SetMaxInactiveFps(inactiveMaxFps_);
 	}
 
 	Editor::Editor(Context* context) : Object(context),
 		visible_(false),
+		idle_(false),
+		idleTime_(0.0f),
+		idleDelay_(0.5f),
+		idleFps_(10),
+		inactiveMaxFps_(0),
 		editorPluginMain_(NULL),
 		editorPluginOver_(NULL)
 	{
+		Engine* engine = GetSubsystem<Engine>();
+		if (engine)
+			inactiveMaxFps_ = engine->GetMaxInactiveFps();
 	}
 
 	bool Editor::Create(Scene* scene, UIElement* sceneUI)
@@ -145,6 +161,8 @@ namespace Urho3D
 		/// remove the title bar from the window
 		hierarchyWindow_->SetTitleBarVisible(false);
 
+		SubscribeToEvent(hierarchyWindow_->GetHierarchyList(), E_ITEMSELECTED, HANDLER(Editor, HandleHierarchyListItemSelected));
+		SubscribeToEvent(hierarchyWindow_->GetHierarchyList(), E_ITEMDESELECTED, HANDLER(Editor, HandleHierarchyListItemDeselected));
 		SubscribeToEvent(hierarchyWindow_->GetHierarchyList(), E_SELECTIONCHANGED, HANDLER(Editor, HandleHierarchyListSelectionChange));
 		SubscribeToEvent(hierarchyWindow_->GetHierarchyList(), E_ITEMDOUBLECLICKED, HANDLER(Editor, HandleHierarchyListDoubleClick));
 
@@ -155,9 +173,29 @@ namespace Urho3D
 		/// connect the hierarchy with the editable  ui.
 		hierarchyWindow_->SetUIElement(sceneUI);
 
+		//////////////////////////////////////////////////////////////////////////
+		/// create the scene statistics
+		statsWindow_ = new SceneStatsWindow(context_);
+		statsWindow_->SetTitle("Scene Statistics");
+		statsWindow_->SetDefaultStyle(editorData_->defaultStyle_);
+		statsWindow_->SetStyleAuto();
+		statsWindow_->SetTexture(cache_->GetResource<Texture2D>("Textures/UI.png"));
+		statsWindow_->SetImageRect(IntRect(112, 0, 128, 16));
+		statsWindow_->SetBorder(IntRect(2, 2, 2, 2));
+		statsWindow_->SetResizeBorder(IntRect(0, 0, 0, 0));
+		statsWindow_->SetLayoutSpacing(0);
+		statsWindow_->SetLayoutBorder(IntRect(0, 4, 0, 0));
+		statsWindow_->SetTitleBarVisible(false);
+
+		SubscribeToEvent(statsWindow_->GetStatsList(), E_ITEMDOUBLECLICKED, HANDLER(Editor, HandleStatsListDoubleClick));
+
+		editorView_->GetLeftFrame()->AddTab("Statistics", statsWindow_);
+		statsWindow_->SetScene(scene_);
+
 		//////////////////////////////////////////////////////////////////////////
 		/// create the attribute editor
 		attributeWindow_ = new AttributeInspector(context_);
+		attributeWindow_->SetEditorSelection(editorSelection_);
 		Window* atrele = (Window*)attributeWindow_->Create();
 		atrele->SetResizable(false);
 		atrele->SetMovable(false);
@@ -178,6 +216,26 @@ namespace Urho3D
 		SubscribeToEvent(editorView_->GetMiddleFrame(), E_ACTIVETABCHANGED, HANDLER(Editor, HandleMainEditorTabChanged));
 		SubscribeToEvent(E_UPDATE, HANDLER(Editor, HandleUpdate));
 
+		/// anything that can change what is displayed ends the idle mode
+		SubscribeToEvent(E_KEYDOWN, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_KEYUP, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_TEXTINPUT, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_MOUSEMOVE, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_MOUSEBUTTONDOWN, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_MOUSEBUTTONUP, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_MOUSEWHEEL, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_TOUCHBEGIN, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_TOUCHMOVE, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_TOUCHEND, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_INPUTFOCUS, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_SCREENMODE, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_FILECHANGED, HANDLER(Editor, HandleActivity));
+		SubscribeToEvent(E_ENDFRAME, HANDLER(Editor, HandleEndFrame));
+
+		/// a backgrounded editor only needs to stay responsive
+		if (idleFps_ > 0)
+			GetSubsystem<Engine>()->SetMaxInactiveFps(idleFps_);
+
 		visible_ = true;
 		return true;
 	}
@@ -279,15 +337,14 @@ namespace Urho3D
 		// 	UpdateWindowTitle();
 		// 	DisableInspectorLock();
 		hierarchyWindow_->UpdateHierarchyItem(scene_, true);
+		statsWindow_->Refresh();
 		// 	ClearEditActions();
 		//
 
 		hierarchyWindow_->SetSuppressSceneChanges(false);
 		/// \todo
 		editorSelection_->ClearSelection();
-		attributeWindow_->GetEditNodes() = editorSelection_->GetEditNodes();
-		attributeWindow_->GetEditComponents() = editorSelection_->GetEditComponents();
-		attributeWindow_->GetEditUIElements() = editorSelection_->GetEditUIElements();
+		editorSelection_->SendSelectionChanged();
 		attributeWindow_->Update();
 		//
 		// 	// global variable to mostly bypass adding mru upon importing tempscene
@@ -436,7 +493,59 @@ namespace Urho3D
 		}
 		if (resourceBrowser_->IsVisible())
 			resourceBrowser_->Update();
-		
+		statsWindow_->Update(timestep);
+
+		if ((editorPluginMain_ && editorPluginMain_->IsBusy()) || (editorPluginOver_ && editorPluginOver_->IsBusy()))
+			idleTime_ = 0.0f;
+		else
+			idleTime_ += timestep;
+
+		if (idleTime_ >= idleDelay_ && idleFps_ > 0)
+			SetIdle(true);
+		else if (idleTime_ < idleDelay_)
+			SetIdle(false);
+	}
+
+	void Editor::HandleActivity(StringHash eventType, VariantMap& eventData)
+	{
+		idleTime_ = 0.0f;
+		SetIdle(false);
+	}
+
+	void Editor::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+	{
+		if (!idle_)
+			return;
+
+		// The engine frame limit would sleep through input, so the idle frame rate is kept here and any pending event
+		// ends the sleep. The next frame handles it and wakes the editor at the full frame rate.
+		long long frameUSec = 1000000LL / idleFps_;
+		while (idleFrameTimer_.GetUSec(false) < frameUSec)
+		{
+			SDL_PumpEvents();
+			if (SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT))
+				break;
+			Time::Sleep(1);
+		}
+		idleFrameTimer_.Reset();
+	}
+
+	void Editor::SetIdle(bool idle)
+	{
+		if (idle == idle_)
+			return;
+
+		// Views in manual update mode render nothing while idle, HandleEndFrame limits the frame rate
+		idle_ = idle;
+		idleFrameTimer_.Reset();
+	}
+
+	void Editor::SetIdleFps(int fps)
+	{
+		idleFps_ = Max(fps, 0);
+		GetSubsystem<Engine>()->SetMaxInactiveFps(idleFps_ > 0 ? idleFps_ : inactiveMaxFps_);
+		if (idleFps_ == 0)
+			SetIdle(false);
 	}
 
 	void Editor::HandleMenuBarAction(StringHash eventType, VariantMap& eventData)
@@ -481,11 +590,22 @@ namespace Urho3D
 
 	void Editor::HandleHierarchyListSelectionChange(StringHash eventType, VariantMap& eventData)
 	{
-		editorSelection_->OnHierarchyListSelectionChange(hierarchyWindow_->GetHierarchyList()->GetItems(), hierarchyWindow_->GetHierarchyList()->GetSelections());
-		/// \todo dont copy
-		attributeWindow_->GetEditNodes() = editorSelection_->GetEditNodes();
-		attributeWindow_->GetEditComponents() = editorSelection_->GetEditComponents();
-		attributeWindow_->GetEditUIElements() = editorSelection_->GetEditUIElements();
+		ListView* hierarchyList = hierarchyWindow_->GetHierarchyList();
+		const PODVector<unsigned>& selections = hierarchyList->GetSelections();
+
+		// items removed from the list drop their selection without a deselect event, resync from the list in that case
+		if (editorSelection_->GetNumListSelections() + hierarchySelectedItems_.Size() - hierarchyDeselectedItems_.Size() != selections.Size())
+		{
+			editorSelection_->ClearSelection();
+			hierarchySelectedItems_.Clear();
+			hierarchyDeselectedItems_.Clear();
+			for (unsigned i = 0; i < selections.Size(); ++i)
+				hierarchySelectedItems_.Push(hierarchyList->GetItem(selections[i]));
+		}
+
+		editorSelection_->OnHierarchyListSelectionChange(hierarchySelectedItems_, hierarchyDeselectedItems_);
+		hierarchySelectedItems_.Clear();
+		hierarchyDeselectedItems_.Clear();
 		attributeWindow_->Update();
 
 		// 	OnSelectionChange();
@@ -495,6 +615,24 @@ namespace Urho3D
 		// 	// 		UpdateCameraPreview();
 	}
 
+	void Editor::HandleHierarchyListItemSelected(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ItemSelected;
+
+		UIElement* item = hierarchyWindow_->GetHierarchyList()->GetItem(eventData[P_SELECTION].GetUInt());
+		if (item)
+			hierarchySelectedItems_.Push(item);
+	}
+
+	void Editor::HandleHierarchyListItemDeselected(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ItemDeselected;
+
+		UIElement* item = hierarchyWindow_->GetHierarchyList()->GetItem(eventData[P_SELECTION].GetUInt());
+		if (item)
+			hierarchyDeselectedItems_.Push(item);
+	}
+
 	void Editor::HandleHierarchyListDoubleClick(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace ItemDoubleClicked;
@@ -503,6 +641,24 @@ namespace Urho3D
 		/// \todo
 	}
 
+	void Editor::HandleStatsListDoubleClick(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ItemDoubleClicked;
+
+		UIElement* item = static_cast<UIElement*>(eventData[P_ITEM].GetPtr());
+		Node* node = statsWindow_->GetItemNode(item);
+		if (!node)
+			return;
+
+		ListView* list = hierarchyWindow_->GetHierarchyList();
+		unsigned index = hierarchyWindow_->GetListIndex(node);
+		if (index != NO_ITEM)
+		{
+			list->SetSelection(index);
+			list->EnsureItemVisibility(index);
+		}
+	}
+
 	void Editor::AddResourcePath(String newPath, bool usePreferredDir /*= true*/)
 	{
 		if (newPath.Empty())
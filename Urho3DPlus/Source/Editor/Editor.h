@@ -3,6 +3,7 @@
 #include "../Core/Object.h"
 #include "../Container/Vector.h"
 #include "../Core/Variant.h"
+#include "../Core/Timer.h"
 
 namespace Urho3D
 {
@@ -24,6 +25,7 @@ namespace Urho3D
 	class MiniToolBarUI;
 	class ToolBarUI;
 	class HierarchyWindow;
+	class SceneStatsWindow;
 	class EditorSelection;
 	class AttributeInspector;
 	class EditorData;
@@ -62,6 +64,7 @@ namespace Urho3D
 		UIElement*	GetListUIElement(UIElement*  item);
 		UIElement*	GetUIElementByID(const Variant& id);
 		HierarchyWindow*	GetHierarchyWindow() { return hierarchyWindow_; }
+		SceneStatsWindow*	GetStatsWindow() { return statsWindow_; }
 		AttributeInspector* GetAttributeWindow() { return attributeWindow_; }
 		EditorSelection*	GetEditorSelection() { return editorSelection_; }
 		EditorData*			GetEditorData() { return editorData_; }
@@ -85,6 +88,12 @@ namespace Urho3D
 		void			CloseFileSelector();
 		FileSelector*	GetUIFileSelector();
 
+		/// frame rate limit while nothing happens, 0 disables idle throttling
+		void SetIdleFps(int fps);
+		int GetIdleFps() const { return idleFps_; }
+		/// return true if there was no input, no resource change and no busy plugin for a while
+		bool IsIdle() const { return idle_; }
+
 	protected:
 		void HandleUpdate(StringHash eventType, VariantMap& eventData);
 		/// Handle Menu Bar Events
@@ -93,7 +102,17 @@ namespace Urho3D
 		void HandleMainEditorTabChanged(StringHash eventType, VariantMap& eventData);
 		/// handle Hierarchy Events
 		void HandleHierarchyListSelectionChange(StringHash eventType, VariantMap& eventData);
+		/// collect the items the hierarchy list selected and deselected since the last selection change
+		void HandleHierarchyListItemSelected(StringHash eventType, VariantMap& eventData);
+		void HandleHierarchyListItemDeselected(StringHash eventType, VariantMap& eventData);
 		void HandleHierarchyListDoubleClick(StringHash eventType, VariantMap& eventData);
+		/// select the node of a double clicked statistics row
+		void HandleStatsListDoubleClick(StringHash eventType, VariantMap& eventData);
+		/// input and file changes wake the editor up
+		void HandleActivity(StringHash eventType, VariantMap& eventData);
+		/// sleep away the rest of an idle frame, pending input ends it early
+		void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+		void SetIdle(bool idle);
 
 		void AddResourcePath(String newPath, bool usePreferredDir = true);
 
@@ -106,6 +125,16 @@ namespace Urho3D
 
 		/// is the editor visible, used for the in game editor
 		bool visible_;
+		/// idle handling
+		bool idle_;
+		float idleTime_;
+		/// seconds without activity until the editor goes idle
+		float idleDelay_;
+		int idleFps_;
+		/// engine frame limit for an inactive window, restored when the editor is destroyed
+		int inactiveMaxFps_;
+		/// time since the last idle frame ended
+		HiresTimer idleFrameTimer_;
 		/// currently edited
 		SharedPtr<Scene>		scene_;
 		SharedPtr<UIElement>	sceneRootUI_;
@@ -126,6 +155,10 @@ namespace Urho3D
 
 		/// default IDE Editors
 		SharedPtr<HierarchyWindow>		hierarchyWindow_;
+		/// hierarchy list items selected and deselected since the last selection change
+		PODVector<UIElement*>			hierarchySelectedItems_;
+		PODVector<UIElement*>			hierarchyDeselectedItems_;
+		SharedPtr<SceneStatsWindow>		statsWindow_;
 		SharedPtr<AttributeInspector>	attributeWindow_;
 		SharedPtr<ResourceBrowser>		resourceBrowser_;
 
@@ -45,6 +45,8 @@ namespace Urho3D
 		bool IsVisible() { return visible_; }
 		/// update is called only for main plugins. 
 		virtual void Update(float timeStep) {  }
+		/// return true while the plugin needs frames without user input, e.g. a running or loading scene.
+		virtual bool IsBusy() { return false; }
 
 		/// \todo handle changes that a pending (marked as *), external data, save/load editor state ??
 
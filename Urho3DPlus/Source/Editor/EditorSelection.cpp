@@ -36,13 +36,30 @@
 
 namespace Urho3D
 {
+	/// record a change of the selection, undoing a change that was not sent yet leaves no change
+	template <class T> static void NoteSelectionChange(HashSet<T>& changes, HashSet<T>& opposite, const T& key)
+	{
+		if (!opposite.Erase(key))
+			changes.Insert(key);
+	}
 
+	template <class T> static void FillSelectionChanges(HashSet<T>& changes, VariantVector& dest)
+	{
+		dest.Reserve(changes.Size());
+		for (typename HashSet<T>::ConstIterator i = changes.Begin(); i != changes.End(); ++i)
+			dest.Push(Variant(*i));
+		changes.Clear();
+	}
 
 	EditorSelection::EditorSelection(Context* context, Editor* editor) : Object(context),
 		editUIElement_(NULL),
 		editNode_(NULL),
 		numEditableComponentsPerNode_(1),
-		editor_(editor)
+		editor_(editor),
+		editComponentsDirty_(false),
+		editSource_(EDIT_FROM_NONE),
+		editAllComponents_(false),
+		numListSelections_(0)
 	{
 
 	}
@@ -59,9 +76,9 @@ namespace Urho3D
 
 	void EditorSelection::ClearSelection()
 	{
-		selectedNodes_.Clear();
-		selectedComponents_.Clear();
-		selectedUIElements_.Clear();
+		ClearSelectedNodes();
+		ClearSelectedComponents();
+		ClearSelectedUIElements();
 
 		editUIElement_ = NULL;
 		editNode_ = NULL;
@@ -69,42 +86,174 @@ namespace Urho3D
 		editNodes_.Clear();
 		editComponents_.Clear();
 		editUIElements_.Clear();
+		editComponentsDirty_ = false;
+		editSource_ = EDIT_FROM_NONE;
+		componentsIn_.Clear();
+		componentsOut_.Clear();
+		editNodesIn_.Clear();
+		editComponentsOut_.Clear();
+		numListSelections_ = 0;
 
 		numEditableComponentsPerNode_ = 1;
 	}
 
 
 
+	void EditorSelection::ClearSelectedNodes()
+	{
+		for (HashMap<unsigned, SelectedNode>::ConstIterator i = selectedNodesById_.Begin(); i != selectedNodesById_.End(); ++i)
+			NoteSelectionChange(removedNodes_, addedNodes_, i->first_);
+		selectedNodesById_.Clear();
+		slotTypeCounts_.Clear();
+		selectedNodes_.Clear();
+		editComponentsDirty_ = true;
+		editSource_ = EDIT_FROM_NONE;
+	}
+
+	void EditorSelection::ClearSelectedComponents()
+	{
+		for (HashMap<unsigned, SelectedComponent>::ConstIterator i = selectedComponentsById_.Begin(); i != selectedComponentsById_.End(); ++i)
+			NoteSelectionChange(removedComponents_, addedComponents_, i->first_);
+		selectedComponentsById_.Clear();
+		componentNodeCounts_.Clear();
+		componentTypeCounts_.Clear();
+		selectedComponents_.Clear();
+		editComponentsDirty_ = true;
+		editSource_ = EDIT_FROM_NONE;
+	}
+
+	void EditorSelection::ClearSelectedUIElements()
+	{
+		const Vector<UIElement*>& elements = selectedUIElements_.GetItems();
+		for (unsigned i = 0; i < elements.Size(); ++i)
+			NoteSelectionChange(removedUIElements_, addedUIElements_, elements[i]);
+		selectedUIElements_.Clear();
+	}
+
 	void EditorSelection::AddSelectedComponent(Component* comp)
 	{
-		if (comp != NULL)
-			selectedComponents_.Push(comp);
+		if (!selectedComponents_.Insert(comp))
+			return;
+
+		SelectedComponent& selected = selectedComponentsById_[comp->GetID()];
+		selected.component_ = comp;
+		selected.node_ = comp->GetNode();
+		selected.type_ = comp->GetType();
+		++componentNodeCounts_[selected.node_];
+		++componentTypeCounts_[selected.type_];
+		NoteSelectionChange(addedComponents_, removedComponents_, comp->GetID());
+		componentsIn_.Push(comp);
+		editComponentsDirty_ = true;
 	}
 
 	void EditorSelection::AddSelectedNode(Node* node)
 	{
-		if (node != NULL)
-			selectedNodes_.Push(node);
+		if (!selectedNodes_.Insert(node))
+			return;
+
+		SelectedNode& selected = selectedNodesById_[node->GetID()];
+		selected.node_ = node;
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		selected.componentTypes_.Resize(components.Size());
+		if (slotTypeCounts_.Size() < components.Size())
+			slotTypeCounts_.Resize(components.Size());
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			selected.componentTypes_[i] = components[i]->GetType();
+			++slotTypeCounts_[i][selected.componentTypes_[i]];
+		}
+		NoteSelectionChange(addedNodes_, removedNodes_, node->GetID());
+		editNodesIn_.Push(node);
+		editComponentsDirty_ = true;
 	}
 
 	void EditorSelection::AddEditComponent(Component* comp)
 	{
-		if (comp != NULL)
-			editComponents_.Push(comp);
+		UpdateEditComponents();
+		editComponents_.Insert(comp);
 	}
 
 	void EditorSelection::AddEditNode(Node* node)
 	{
-		if (node != NULL)
-			editNodes_.Push(node);
+		editNodes_.Insert(node);
 	}
 
 
 
 	void EditorSelection::AddSelectedUIElement(UIElement* element)
 	{
-		if (element != NULL)
-			selectedUIElements_.Push(element);
+		if (selectedUIElements_.Insert(element))
+			NoteSelectionChange(addedUIElements_, removedUIElements_, element);
+	}
+
+	void EditorSelection::RemoveSelectedComponent(Component* comp)
+	{
+		if (comp != NULL && selectedComponents_.Contains(comp))
+			RemoveSelectedComponentByID(comp->GetID());
+	}
+
+	void EditorSelection::RemoveSelectedNode(Node* node)
+	{
+		if (node != NULL && selectedNodes_.Contains(node))
+			RemoveSelectedNodeByID(node->GetID());
+	}
+
+	void EditorSelection::RemoveSelectedUIElement(UIElement* element)
+	{
+		if (selectedUIElements_.Erase(element))
+			NoteSelectionChange(removedUIElements_, addedUIElements_, element);
+	}
+
+	void EditorSelection::RemoveEditNode(Node* node)
+	{
+		editNodes_.Erase(node);
+	}
+
+	Node* EditorSelection::RemoveSelectedNodeByID(unsigned id)
+	{
+		HashMap<unsigned, SelectedNode>::Iterator i = selectedNodesById_.Find(id);
+		if (i == selectedNodesById_.End())
+			return NULL;
+
+		const PODVector<StringHash>& types = i->second_.componentTypes_;
+		for (unsigned j = 0; j < types.Size(); ++j)
+		{
+			HashMap<StringHash, unsigned>::Iterator count = slotTypeCounts_[j].Find(types[j]);
+			if (--count->second_ == 0)
+				slotTypeCounts_[j].Erase(count);
+		}
+
+		// Only the pointers are needed to take them out, the node may be destroyed already
+		editComponentsOut_.Push(i->second_.editComponents_);
+
+		Node* node = i->second_.node_;
+		selectedNodes_.Erase(node);
+		selectedNodesById_.Erase(i);
+		NoteSelectionChange(removedNodes_, addedNodes_, id);
+		editComponentsDirty_ = true;
+		return node;
+	}
+
+	Component* EditorSelection::RemoveSelectedComponentByID(unsigned id)
+	{
+		HashMap<unsigned, SelectedComponent>::Iterator i = selectedComponentsById_.Find(id);
+		if (i == selectedComponentsById_.End())
+			return NULL;
+
+		HashMap<Node*, unsigned>::Iterator nodeCount = componentNodeCounts_.Find(i->second_.node_);
+		if (--nodeCount->second_ == 0)
+			componentNodeCounts_.Erase(nodeCount);
+		HashMap<StringHash, unsigned>::Iterator typeCount = componentTypeCounts_.Find(i->second_.type_);
+		if (--typeCount->second_ == 0)
+			componentTypeCounts_.Erase(typeCount);
+
+		Component* comp = i->second_.component_;
+		selectedComponents_.Erase(comp);
+		selectedComponentsById_.Erase(i);
+		NoteSelectionChange(removedComponents_, addedComponents_, id);
+		componentsOut_.Push(comp);
+		editComponentsDirty_ = true;
+		return comp;
 	}
 
 	unsigned EditorSelection::GetNumSelectedUIElements()
@@ -124,6 +273,7 @@ namespace Urho3D
 
 	unsigned EditorSelection::GetNumEditComponents()
 	{
+		UpdateEditComponents();
 		return editComponents_.Size();
 	}
 
@@ -152,9 +302,9 @@ namespace Urho3D
 		return editUIElement_;
 	}
 
-	Vector<UIElement*> EditorSelection::GetEditUIElements()
+	const Vector<UIElement*>& EditorSelection::GetEditUIElements()
 	{
-		return editUIElements_;
+		return editUIElements_.GetItems();
 	}
 
 	void EditorSelection::SetNumEditableComponentsPerNode(unsigned int num)
@@ -164,69 +314,90 @@ namespace Urho3D
 
 	unsigned int EditorSelection::GetNumEditableComponentsPerNode()
 	{
+		UpdateEditComponents();
 		return numEditableComponentsPerNode_;
 	}
 
 	void EditorSelection::AddEditUIElement(UIElement* element)
 	{
-		if (element != NULL)
-			editUIElements_.Push(element);
+		editUIElements_.Insert(element);
 	}
 
 
-	void EditorSelection::SetSelectedNodes(Vector<Node*>& nodes)
+	void EditorSelection::SetSelectedNodes(const Vector<Node*>& nodes)
 	{
-		selectedNodes_ = nodes;
+		// Nodes that stay selected cancel out in the changes
+		ClearSelectedNodes();
+		for (unsigned i = 0; i < nodes.Size(); ++i)
+			AddSelectedNode(nodes[i]);
 	}
 
-	void EditorSelection::SetSelectedComponents(Vector<Component*>& comps)
+	void EditorSelection::SetSelectedComponents(const Vector<Component*>& comps)
 	{
-		selectedComponents_ = comps;
+		ClearSelectedComponents();
+		for (unsigned i = 0; i < comps.Size(); ++i)
+			AddSelectedComponent(comps[i]);
 	}
 
-	void EditorSelection::SetSelectedUIElements(Vector<UIElement*>& elemets)
+	void EditorSelection::SetSelectedUIElements(const Vector<UIElement*>& elemets)
 	{
-		selectedUIElements_ = elemets;
+		ClearSelectedUIElements();
+		for (unsigned i = 0; i < elemets.Size(); ++i)
+			AddSelectedUIElement(elemets[i]);
 	}
 
-	void EditorSelection::SetEditNodes(Vector<Node*>& nodes)
+	void EditorSelection::SetEditNodes(const Vector<Node*>& nodes)
 	{
-		editNodes_ = nodes;
+		editNodes_.Clear();
+		for (unsigned i = 0; i < nodes.Size(); ++i)
+			editNodes_.Insert(nodes[i]);
 	}
 
-	void EditorSelection::SetEditComponents(Vector<Component*>& comps)
+	void EditorSelection::SetEditComponents(const Vector<Component*>& comps)
 	{
-		editComponents_ = comps;
+		editComponentsDirty_ = false;
+		// Set from outside, the next selection change rebuilds them
+		editSource_ = EDIT_FROM_NONE;
+		componentsIn_.Clear();
+		componentsOut_.Clear();
+		editNodesIn_.Clear();
+		editComponentsOut_.Clear();
+		editComponents_.Clear();
+		for (unsigned i = 0; i < comps.Size(); ++i)
+			editComponents_.Insert(comps[i]);
 	}
 
-	void EditorSelection::SetEditUIElements(Vector<UIElement*>& elements)
+	void EditorSelection::SetEditUIElements(const Vector<UIElement*>& elements)
 	{
-		editUIElements_ = elements;
+		editUIElements_.Clear();
+		for (unsigned i = 0; i < elements.Size(); ++i)
+			editUIElements_.Insert(elements[i]);
 	}
 
-	Vector<Node*>& EditorSelection::GetSelectedNodes()
+	const Vector<Node*>& EditorSelection::GetSelectedNodes()
 	{
-		return selectedNodes_;
+		return selectedNodes_.GetItems();
 	}
 
-	Vector<Component*>& EditorSelection::GetSelectedComponents()
+	const Vector<Component*>& EditorSelection::GetSelectedComponents()
 	{
-		return selectedComponents_;
+		return selectedComponents_.GetItems();
 	}
 
-	Vector<UIElement*>& EditorSelection::GetSelectedUIElements()
+	const Vector<UIElement*>& EditorSelection::GetSelectedUIElements()
 	{
-		return selectedUIElements_;
+		return selectedUIElements_.GetItems();
 	}
 
-	Vector<Node*>& EditorSelection::GetEditNodes()
+	const Vector<Node*>& EditorSelection::GetEditNodes()
 	{
-		return editNodes_;
+		return editNodes_.GetItems();
 	}
 
-	Vector<Component*>& EditorSelection::GetEditComponents()
+	const Vector<Component*>& EditorSelection::GetEditComponents()
 	{
-		return editComponents_;
+		UpdateEditComponents();
+		return editComponents_.GetItems();
 	}
 
 	void EditorSelection::SetGlobalVarNames(const String& name)
@@ -241,131 +412,235 @@ namespace Urho3D
 
 
 
-	void EditorSelection::OnHierarchyListSelectionChange(const PODVector<UIElement*>& items, const PODVector<unsigned>& indices)
+	void EditorSelection::SendSelectionChanged()
 	{
-		ClearSelection();
+		if (addedNodes_.Empty() && removedNodes_.Empty() && addedComponents_.Empty() && removedComponents_.Empty() &&
+			addedUIElements_.Empty() && removedUIElements_.Empty())
+			return;
+
+		using namespace EditorSelectionChanged;
+
+		VariantVector addedNodes, removedNodes, addedComponents, removedComponents, addedUIElements, removedUIElements;
+		FillSelectionChanges(addedNodes_, addedNodes);
+		FillSelectionChanges(removedNodes_, removedNodes);
+		FillSelectionChanges(addedComponents_, addedComponents);
+		FillSelectionChanges(removedComponents_, removedComponents);
+		FillSelectionChanges(addedUIElements_, addedUIElements);
+		FillSelectionChanges(removedUIElements_, removedUIElements);
 
-		for (unsigned int i = 0; i < indices.Size(); ++i)
+		VariantMap& eventData = GetEventDataMap();
+		eventData[P_ADDEDNODES] = addedNodes;
+		eventData[P_REMOVEDNODES] = removedNodes;
+		eventData[P_ADDEDCOMPONENTS] = addedComponents;
+		eventData[P_REMOVEDCOMPONENTS] = removedComponents;
+		eventData[P_ADDEDUIELEMENTS] = addedUIElements;
+		eventData[P_REMOVEDUIELEMENTS] = removedUIElements;
+		SendEvent(E_EDITORSELECTIONCHANGED, eventData);
+	}
+
+	void EditorSelection::OnHierarchyListSelectionChange(const PODVector<UIElement*>& selectedItems, const PODVector<UIElement*>& deselectedItems)
+	{
+		nodesIn_.Clear();
+		nodesOut_.Clear();
+
+		// Deselected items are resolved by the IDs they carry, their objects may be gone already
+		for (unsigned int i = 0; i < deselectedItems.Size(); ++i)
 		{
-			unsigned int index = indices[i];
-			UIElement* item = items[index];
+			UIElement* item = deselectedItems[i];
 			int type = item->GetVar(TYPE_VAR).GetInt();
 			if (type == ITEM_COMPONENT)
+				RemoveSelectedComponentByID(item->GetVar(COMPONENT_ID_VAR).GetUInt());
+			else if (type == ITEM_NODE)
 			{
-				Component* comp = editor_->GetListComponent(item);
-
-				AddSelectedComponent(comp);
+				Node* node = RemoveSelectedNodeByID(item->GetVar(NODE_ID_VAR).GetUInt());
+				if (node != NULL)
+					nodesOut_.Push(node);
+			}
+			else if (type == ITEM_UI_ELEMENT)
+			{
+				UIElement* element = editor_->GetListUIElement(item);
+				if (selectedUIElements_.Contains(element))
+				{
+					RemoveSelectedUIElement(element);
+					editUIElements_.Erase(element);
+				}
 			}
+		}
+
+		for (unsigned int i = 0; i < selectedItems.Size(); ++i)
+		{
+			UIElement* item = selectedItems[i];
+			int type = item->GetVar(TYPE_VAR).GetInt();
+			if (type == ITEM_COMPONENT)
+				AddSelectedComponent(editor_->GetListComponent(item));
 			else if (type == ITEM_NODE)
 			{
 				Node* node = editor_->GetListNode(item);
-
-				AddSelectedNode(node);
+				if (node != NULL && !selectedNodes_.Contains(node))
+				{
+					AddSelectedNode(node);
+					nodesIn_.Push(node);
+				}
 			}
 			else if (type == ITEM_UI_ELEMENT)
 			{
 				UIElement* element = editor_->GetListUIElement(item);
-				AddSelectedUIElement(element);
+				if (element != NULL && !selectedUIElements_.Contains(element))
+				{
+					AddSelectedUIElement(element);
+					editUIElements_.Insert(element);
+				}
 			}
 		}
 
+		numListSelections_ += selectedItems.Size();
+		numListSelections_ -= Min(numListSelections_, deselectedItems.Size());
+
 		// If only one node/UIElement selected, use it for editing
-		if (GetNumSelectedNodes() == 1)
-			editNode_ = selectedNodes_[0];
+		unsigned int numNodes = selectedNodes_.Size();
+		editNode_ = NULL;
+		if (numNodes == 1)
+			editNode_ = selectedNodes_.Front();
+		// If selection contains only components, and they have a common node, use it for editing
+		else if (numNodes == 0 && componentNodeCounts_.Size() == 1)
+			editNode_ = componentNodeCounts_.Begin()->first_;
 
-		
-		if (GetNumSelectedUIElements() == 1)
-			editUIElement_ = selectedUIElements_[0];
-		
+		editUIElement_ = selectedUIElements_.Size() == 1 ? selectedUIElements_.Front() : NULL;
 
-		// If selection contains only components, and they have a common node, use it for editing
-		if (selectedNodes_.Empty() && !selectedComponents_.Empty())
+		if (numNodes == 0)
 		{
-			Node* commonNode = NULL;
-			for (unsigned int i = 0; i < GetNumSelectedComponents(); ++i)
-			{
-				if (i == 0)
-					commonNode = GetSelectedComponents()[i]->GetNode();
-				else
-				{
-					if (selectedComponents_[i]->GetNode() != commonNode)
-						commonNode = NULL;
-				}
-			}
-			editNode_ = commonNode;
+			// Every previously selected node was removed by this change, so this is no more work than the change itself
+			editNodes_.Clear();
+			if (editNode_ != NULL)
+				AddEditNode(editNode_);
 		}
+		else
+		{
+			// The edit nodes follow the selected nodes, unless they held the common node of the selected components
+			if (editNodes_.Size() == 1 && !selectedNodes_.Contains(editNodes_.Front()))
+				editNodes_.Clear();
+			for (unsigned int i = 0; i < nodesOut_.Size(); ++i)
+				editNodes_.Erase(nodesOut_[i]);
+			for (unsigned int i = 0; i < nodesIn_.Size(); ++i)
+				editNodes_.Insert(nodesIn_[i]);
 
-		// Now check if the component(s) can be edited. If many selected, must have same type or have same edit node
+			// Cannot multi-edit on scene and node(s) together as scene and node do not share identical attributes,
+			// editing via gizmo does not make too much sense either
+			Node* scene = editor_->GetScene();
+			if (numNodes > 1 && selectedNodes_.Front() == scene)
+				editNodes_.Erase(scene);
+			else if (selectedNodes_.Contains(scene))
+				editNodes_.Insert(scene);
+		}
+
+		SendSelectionChanged();
+	}
+
+	void EditorSelection::UpdateEditComponents()
+	{
+		if (!editComponentsDirty_)
+			return;
+		editComponentsDirty_ = false;
+
+		EditComponentsSource source = EDIT_FROM_NONE;
 		if (!selectedComponents_.Empty())
+			source = EDIT_FROM_COMPONENTS;
+		else if (!selectedNodes_.Empty())
+			source = EDIT_FROM_NODES;
+
+		// Now check if the component(s) can be edited. If many selected, must have same type or have same edit node
+		if (source == EDIT_FROM_COMPONENTS)
 		{
-			if (editNode_ == NULL)
+			bool editAll = editNode_ != NULL || componentTypeCounts_.Size() == 1;
+			if (!editAll)
+				editComponents_.Clear();
+			else if (editSource_ == EDIT_FROM_COMPONENTS && editAllComponents_)
 			{
-				StringHash compType = selectedComponents_[0]->GetType();
-				bool sameType = true;
-				for (unsigned int i = 1; i < GetNumSelectedComponents(); ++i)
+				for (unsigned int i = 0; i < componentsOut_.Size(); ++i)
+					editComponents_.Erase(componentsOut_[i]);
+				for (unsigned int i = 0; i < componentsIn_.Size(); ++i)
 				{
-					if (selectedComponents_[i]->GetType() != compType)
-					{
-						sameType = false;
-						break;
-					}
+					if (selectedComponents_.Contains(componentsIn_[i]))
+						editComponents_.Insert(componentsIn_[i]);
 				}
-				if (sameType)
-					editComponents_ = selectedComponents_;
 			}
 			else
-			{
 				editComponents_ = selectedComponents_;
-				numEditableComponentsPerNode_ = GetNumSelectedComponents();
-			}
-		}
 
+			editAllComponents_ = editAll;
+			numEditableComponentsPerNode_ = editNode_ != NULL ? selectedComponents_.Size() : 1;
+		}
 		// If just nodes selected, and no components, show as many matching components for editing as possible
-		if (!selectedNodes_.Empty() && selectedComponents_.Empty() && selectedNodes_[0]->GetNumComponents() > 0)
+		else if (source == EDIT_FROM_NODES)
 		{
-			unsigned int count = 0;
-			for (unsigned int j = 0; j < selectedNodes_[0]->GetNumComponents(); ++j)
+			GetMatchingSlots(newMatchingSlots_);
+			if (editSource_ == EDIT_FROM_NODES && newMatchingSlots_ == matchingSlots_)
 			{
-				StringHash compType = selectedNodes_[0]->GetComponents()[j]->GetType();
-				bool sameType = true;
-				for (unsigned int i = 1; i < GetNumSelectedNodes(); ++i)
+				// The same components are editable, only the changed nodes add or take out theirs
+				for (unsigned int i = 0; i < editComponentsOut_.Size(); ++i)
+					editComponents_.Erase(editComponentsOut_[i]);
+				for (unsigned int i = 0; i < editNodesIn_.Size(); ++i)
 				{
-					if (selectedNodes_[i]->GetNumComponents() <= j || selectedNodes_[i]->GetComponents()[j]->GetType() != compType)
-					{
-						sameType = false;
-						break;
-					}
-				}
-
-				if (sameType)
-				{
-					++count;
-					for (unsigned int i = 0; i < GetNumSelectedNodes(); ++i)
-						AddEditComponent(selectedNodes_[i]->GetComponents()[j]);
+					Node* node = editNodesIn_[i];
+					if (!selectedNodes_.Contains(node))
+						continue;
+					HashMap<unsigned, SelectedNode>::Iterator selected = selectedNodesById_.Find(node->GetID());
+					if (selected != selectedNodesById_.End())
+						AddNodeEditComponents(selected->second_, newMatchingSlots_);
 				}
 			}
-			if (count > 1)
-				numEditableComponentsPerNode_ = count;
-		}
+			else
+			{
+				editComponents_.Clear();
+				const Vector<Node*>& nodes = GetSelectedNodes();
+				for (unsigned int i = 0; i < nodes.Size(); ++i)
+					AddNodeEditComponents(selectedNodesById_[nodes[i]->GetID()], newMatchingSlots_);
+				matchingSlots_ = newMatchingSlots_;
+			}
 
-		if (selectedNodes_.Empty() && editNode_ != NULL)
-			AddEditNode(editNode_);
+			numEditableComponentsPerNode_ = matchingSlots_.Size() > 1 ? matchingSlots_.Size() : 1;
+		}
 		else
 		{
-			editNodes_ = selectedNodes_;
+			editComponents_.Clear();
+			numEditableComponentsPerNode_ = 1;
+		}
 
-			// Cannot multi-edit on scene and node(s) together as scene and node do not share identical attributes,
-			// editing via gizmo does not make too much sense either
-			if (editNodes_.Size() > 1 && editNodes_[0] == editor_->GetScene())
-				editNodes_.Erase(0);
+		editSource_ = source;
+		componentsIn_.Clear();
+		componentsOut_.Clear();
+		editNodesIn_.Clear();
+		editComponentsOut_.Clear();
+	}
+
+	void EditorSelection::GetMatchingSlots(PODVector<unsigned>& dest) const
+	{
+		dest.Clear();
+		unsigned numNodes = selectedNodes_.Size();
+		for (unsigned int j = 0; j < slotTypeCounts_.Size(); ++j)
+		{
+			// One type at this index for all the selected nodes
+			const HashMap<StringHash, unsigned>& types = slotTypeCounts_[j];
+			if (types.Size() == 1 && types.Begin()->second_ == numNodes)
+				dest.Push(j);
 		}
+	}
 
-		if (selectedUIElements_.Empty() && editUIElement_ != NULL)
-			AddEditUIElement(editUIElement_);
-		else
-			editUIElements_ = selectedUIElements_;
+	void EditorSelection::AddNodeEditComponents(SelectedNode& selected, const PODVector<unsigned>& slots)
+	{
+		selected.editComponents_.Clear();
 
+		// The types were taken when the node was selected, components may have been added or removed since
+		const Vector<SharedPtr<Component> >& components = selected.node_->GetComponents();
+		for (unsigned int i = 0; i < slots.Size(); ++i)
+		{
+			unsigned int j = slots[i];
+			if (j >= components.Size() || components[j]->GetType() != slotTypeCounts_[j].Begin()->first_)
+				continue;
 
+			editComponents_.Insert(components[j]);
+			selected.editComponents_.Push(components[j]);
+		}
 	}
 
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "../Core/Object.h"
 
 #include "../Container/Vector.h"
+#include "../Container/HashMap.h"
+#include "../Container/HashSet.h"
 #include "../Core/Variant.h"
 #include "Utils/Macros.h"
 
@@ -30,6 +32,105 @@ namespace Urho3D
 	class FileSelector;
 	class Camera;
 
+	/// the selection changed, sent once per change with what was added and removed
+	EVENT(E_EDITORSELECTIONCHANGED, EditorSelectionChanged)
+	{
+		PARAM(P_ADDEDNODES, AddedNodes);				// VariantVector of node IDs
+		PARAM(P_REMOVEDNODES, RemovedNodes);			// VariantVector of node IDs
+		PARAM(P_ADDEDCOMPONENTS, AddedComponents);		// VariantVector of component IDs
+		PARAM(P_REMOVEDCOMPONENTS, RemovedComponents);	// VariantVector of component IDs
+		PARAM(P_ADDEDUIELEMENTS, AddedUIElements);		// VariantVector of UIElement pointers
+		PARAM(P_REMOVEDUIELEMENTS, RemovedUIElements);	// VariantVector of UIElement pointers, NULL if destroyed already
+	}
+
+	/// set of selected objects that keeps the order they were added in. Add, remove and lookup are constant time,
+	/// removed slots are compacted out the next time the items are read.
+	template <class T> class SelectionSet
+	{
+	public:
+		SelectionSet() :
+			numRemoved_(0),
+			start_(0)
+		{
+		}
+
+		/// add the item, false if it is NULL or already in the set
+		bool Insert(T* item)
+		{
+			if (item == NULL || index_.Contains(item))
+				return false;
+			index_[item] = items_.Size();
+			items_.Push(item);
+			return true;
+		}
+
+		/// remove the item, false if it was not in the set
+		bool Erase(T* item)
+		{
+			typename HashMap<T*, unsigned>::Iterator i = index_.Find(item);
+			if (i == index_.End())
+				return false;
+			items_[i->second_] = NULL;
+			index_.Erase(i);
+			++numRemoved_;
+			return true;
+		}
+
+		bool Contains(T* item) const { return index_.Contains(item); }
+
+		void Clear()
+		{
+			items_.Clear();
+			index_.Clear();
+			numRemoved_ = 0;
+			start_ = 0;
+		}
+
+		unsigned Size() const { return items_.Size() - numRemoved_; }
+		bool Empty() const { return Size() == 0; }
+
+		/// first item without compacting the set, NULL if empty
+		T* Front() const
+		{
+			while (start_ < items_.Size() && items_[start_] == NULL)
+				++start_;
+			return start_ < items_.Size() ? items_[start_] : NULL;
+		}
+
+		/// items in the order they were added. The vector is only valid until the set changes.
+		const Vector<T*>& GetItems() const
+		{
+			Compact();
+			return items_;
+		}
+
+	private:
+		void Compact() const
+		{
+			if (numRemoved_ == 0)
+				return;
+
+			unsigned count = 0;
+			for (unsigned i = 0; i < items_.Size(); ++i)
+			{
+				if (items_[i] == NULL)
+					continue;
+				items_[count] = items_[i];
+				index_[items_[i]] = count;
+				++count;
+			}
+			items_.Resize(count);
+			numRemoved_ = 0;
+			start_ = 0;
+		}
+
+		mutable Vector<T*> items_;
+		/// position of every item in items_
+		mutable HashMap<T*, unsigned> index_;
+		mutable unsigned numRemoved_;
+		/// the slots before it are all removed
+		mutable unsigned start_;
+	};
 
 	class EditorSelection : public Object
 	{
@@ -48,6 +149,14 @@ namespace Urho3D
 		void AddEditNode(Node* node);
 		void AddSelectedUIElement(UIElement* element);
 		void AddEditUIElement(UIElement* element);
+		void RemoveSelectedComponent(Component* comp);
+		void RemoveSelectedNode(Node* node);
+		void RemoveSelectedUIElement(UIElement* element);
+		void RemoveEditNode(Node* node);
+
+		bool IsSelected(Node* node) const { return selectedNodes_.Contains(node); }
+		bool IsSelected(Component* comp) const { return selectedComponents_.Contains(comp); }
+		bool IsSelected(UIElement* element) const { return selectedUIElements_.Contains(element); }
 
 		unsigned GetNumSelectedUIElements();
 		unsigned GetNumSelectedComponents();
@@ -55,42 +164,118 @@ namespace Urho3D
 		unsigned GetNumEditComponents();
 		unsigned GetNumEditNodes();
 
-		Vector<Node*>&		GetSelectedNodes();
-		Vector<Component*>&	GetSelectedComponents();
-		Vector<UIElement*>&	GetSelectedUIElements();
-		Vector<Node*>&		GetEditNodes();
-		Vector<Component*>&	GetEditComponents();
+		const Vector<Node*>&		GetSelectedNodes();
+		const Vector<Component*>&	GetSelectedComponents();
+		const Vector<UIElement*>&	GetSelectedUIElements();
+		const Vector<Node*>&		GetEditNodes();
+		const Vector<Component*>&	GetEditComponents();
 		UIElement*			GetEditUIElement();
-		Vector<UIElement*>	GetEditUIElements();
+		const Vector<UIElement*>&	GetEditUIElements();
 		Node*				GetEditNode();
 		unsigned int		GetNumEditableComponentsPerNode();
 
 		void	SetEditNode(Node* node);
 		void	SetEditUIElement(UIElement* element);
-		void	SetSelectedNodes(Vector<Node*>& nodes);
-		void	SetSelectedComponents(Vector<Component*>& comps);
-		void	SetSelectedUIElements(Vector<UIElement*>& elemets);
-		void	SetEditNodes(Vector<Node*>& nodes);
-		void	SetEditComponents(Vector<Component*>& comps);
-		void	SetEditUIElements(Vector<UIElement*>& elements);
+		void	SetSelectedNodes(const Vector<Node*>& nodes);
+		void	SetSelectedComponents(const Vector<Component*>& comps);
+		void	SetSelectedUIElements(const Vector<UIElement*>& elemets);
+		void	SetEditNodes(const Vector<Node*>& nodes);
+		void	SetEditComponents(const Vector<Component*>& comps);
+		void	SetEditUIElements(const Vector<UIElement*>& elements);
 		void	SetNumEditableComponentsPerNode(unsigned int num);
 
 		void			SetGlobalVarNames(const String& name);
 		const Variant&	GetGlobalVarNames(StringHash& name);
 
-		void OnHierarchyListSelectionChange(const PODVector<UIElement*>& items, const PODVector<unsigned>& indices);
+		/// apply the items the hierarchy list selected and deselected since the last change, then update the edit nodes and
+		/// components. The cost depends on the size of the change, not on the size of the selection.
+		void OnHierarchyListSelectionChange(const PODVector<UIElement*>& selectedItems, const PODVector<UIElement*>& deselectedItems);
+		/// hierarchy list items the selection was built from, compared to the list to detect changes without item events
+		unsigned GetNumListSelections() const { return numListSelections_; }
+		/// send E_EDITORSELECTIONCHANGED with the changes since the last call, nothing if the selection is the same
+		void SendSelectionChanged();
 	protected:
 		/// Selection
-		Vector<Node*>		selectedNodes_;
-		Vector<Component*>	selectedComponents_;
-		Vector<UIElement*>	selectedUIElements_;
+		SelectionSet<Node>		selectedNodes_;
+		SelectionSet<Component>	selectedComponents_;
+		SelectionSet<UIElement>	selectedUIElements_;
 
 		UIElement*	editUIElement_;
 		Node*		editNode_;
 		Editor* editor_;
-		Vector<Node*>		editNodes_;
-		Vector<Component*>	editComponents_;
-		Vector<UIElement*>	editUIElements_;
+		SelectionSet<Node>		editNodes_;
+		SelectionSet<Component>	editComponents_;
+		SelectionSet<UIElement>	editUIElements_;
+
+		struct SelectedNode
+		{
+			Node* node_;
+			/// component types when selected, for matching the components of the selected nodes
+			PODVector<StringHash> componentTypes_;
+			/// components of the node in the edit components, taken out again when the node is deselected
+			PODVector<Component*> editComponents_;
+		};
+
+		/// what the edit components were built from
+		enum EditComponentsSource
+		{
+			EDIT_FROM_NONE = 0,
+			EDIT_FROM_COMPONENTS,
+			EDIT_FROM_NODES
+		};
+
+		struct SelectedComponent
+		{
+			Component* component_;
+			Node* node_;
+			StringHash type_;
+		};
+
+		void ClearSelectedNodes();
+		void ClearSelectedComponents();
+		void ClearSelectedUIElements();
+		/// remove by ID, the object may be destroyed already. Returns the removed object or NULL.
+		Node* RemoveSelectedNodeByID(unsigned id);
+		Component* RemoveSelectedComponentByID(unsigned id);
+		/// patch the edit components with the selection changes since they were last read, or rebuild them if what is
+		/// editable changed
+		void UpdateEditComponents();
+		/// component indices where all the selected nodes have the same component type
+		void GetMatchingSlots(PODVector<unsigned>& dest) const;
+		/// add the components of a selected node at the matching indices, checked against the node's live components
+		void AddNodeEditComponents(SelectedNode& selected, const PODVector<unsigned>& slots);
+
+		/// selected nodes and components by ID, removed objects may be destroyed already
+		HashMap<unsigned, SelectedNode>			selectedNodesById_;
+		HashMap<unsigned, SelectedComponent>	selectedComponentsById_;
+		/// selected components per node and per type, a single entry means a common node or type
+		HashMap<Node*, unsigned>		componentNodeCounts_;
+		HashMap<StringHash, unsigned>	componentTypeCounts_;
+		/// selected nodes per component type at each component index, a component index is matching when one type has all of them
+		Vector<HashMap<StringHash, unsigned> > slotTypeCounts_;
+		bool editComponentsDirty_;
+		EditComponentsSource editSource_;
+		/// the last built edit components held all selected components
+		bool editAllComponents_;
+		/// matching component indices of the last build from nodes
+		PODVector<unsigned> matchingSlots_;
+		PODVector<unsigned> newMatchingSlots_;
+		/// selection changes since the edit components were last read
+		PODVector<Component*> componentsIn_;
+		PODVector<Component*> componentsOut_;
+		PODVector<Node*> editNodesIn_;
+		PODVector<Component*> editComponentsOut_;
+		unsigned numListSelections_;
+		/// nodes changed by the current hierarchy list change
+		PODVector<Node*> nodesIn_;
+		PODVector<Node*> nodesOut_;
+		/// changes of the selection not sent yet. Adding and then removing an object is no change.
+		HashSet<unsigned>	addedNodes_;
+		HashSet<unsigned>	removedNodes_;
+		HashSet<unsigned>	addedComponents_;
+		HashSet<unsigned>	removedComponents_;
+		HashSet<UIElement*>	addedUIElements_;
+		HashSet<UIElement*>	removedUIElements_;
 
 		unsigned int numEditableComponentsPerNode_;
 
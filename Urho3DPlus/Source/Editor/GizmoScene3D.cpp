@@ -18,18 +18,47 @@
 #include "../Input/Input.h"
 #include "../Graphics/Viewport.h"
 #include "../Graphics/Graphics.h"
+#include "../Graphics/CustomGeometry.h"
 
 namespace Urho3D
 {
 	const float axisMaxD = 0.1f;
 	const float axisMaxT = 1.0f;
 	const float rotSensitivity = 50.0f;
-
-	GizmoScene3D::GizmoScene3D(Context* context, EPScene3D* epScene3D) : Object(context)
+	/// extent of the plane handles along their axes, and half the size of the screen handle
+	const float planeMinExtent = 0.15f;
+	const float planeMaxExtent = 0.4f;
+	const float screenHandleSize = 0.08f;
+
+	static const char* axisMaterialNames[] = {
+		"Materials/Editor/RedUnlit.xml",
+		"Materials/Editor/GreenUnlit.xml",
+		"Materials/Editor/BlueUnlit.xml"
+	};
+
+	static const char* axisHighlightMaterialNames[] = {
+		"Materials/Editor/BrightRedUnlit.xml",
+		"Materials/Editor/BrightGreenUnlit.xml",
+		"Materials/Editor/BrightBlueUnlit.xml"
+	};
+
+	static const char* gizmoModelNames[] = {
+		"Models/Editor/Axes.mdl",
+		"Models/Editor/RotateAxes.mdl",
+		"Models/Editor/ScaleAxes.mdl"
+	};
+
+	GizmoScene3D::GizmoScene3D(Context* context, EPScene3D* epScene3D) : Object(context),
+		hitTestDrag_(false),
+		hitTestValid_(false),
+		planesDirty_(true),
+		previousGizmoDrag(false)
 	{
 		gizmoAxisX = new GizmoAxis(context);
 		gizmoAxisY = new GizmoAxis(context);
 		gizmoAxisZ = new GizmoAxis(context);
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			gizmoPlanes[i] = new GizmoPlane(context);
 		epScene3D_ = epScene3D;
 
 		editorData_ = GetSubsystem<EditorData>();
@@ -44,26 +73,63 @@ namespace Urho3D
 	{
 		ResourceCache* cache = GetSubsystem<ResourceCache>();
 
+		for (unsigned i = 0; i < EDIT_SELECT; ++i)
+			gizmoModels[i] = cache->GetResource<Model>(gizmoModelNames[i]);
+		for (unsigned i = 0; i < 3; ++i)
+		{
+			axisMaterials[i] = cache->GetResource<Material>(axisMaterialNames[i]);
+			axisHighlightMaterials[i] = cache->GetResource<Material>(axisHighlightMaterialNames[i]);
+		}
+
+		// A plane handle has the color of the axis it does not move along, the screen handle is grey
+		planeMaterials[GIZMO_PLANE_XY] = axisMaterials[2];
+		planeMaterials[GIZMO_PLANE_YZ] = axisMaterials[0];
+		planeMaterials[GIZMO_PLANE_XZ] = axisMaterials[1];
+		planeHighlightMaterials[GIZMO_PLANE_XY] = axisHighlightMaterials[2];
+		planeHighlightMaterials[GIZMO_PLANE_YZ] = axisHighlightMaterials[0];
+		planeHighlightMaterials[GIZMO_PLANE_XZ] = axisHighlightMaterials[1];
+		if (axisMaterials[0] != NULL)
+		{
+			planeMaterials[GIZMO_PLANE_SCREEN] = axisMaterials[0]->Clone();
+			planeMaterials[GIZMO_PLANE_SCREEN]->SetShaderParameter("MatDiffColor", Color(0.5f, 0.5f, 0.5f));
+			planeHighlightMaterials[GIZMO_PLANE_SCREEN] = axisMaterials[0]->Clone();
+			planeHighlightMaterials[GIZMO_PLANE_SCREEN]->SetShaderParameter("MatDiffColor", Color(1.0f, 1.0f, 0.0f));
+		}
+
 		gizmoNode = new Node(context_);
 		gizmo = gizmoNode->CreateComponent<StaticModel>();
-		gizmo->SetModel(cache->GetResource<Model>("Models/Editor/Axes.mdl"));
-		gizmo->SetMaterial(0, cache->GetResource<Material>("Materials/Editor/RedUnlit.xml"));
-		gizmo->SetMaterial(1, cache->GetResource<Material>("Materials/Editor/GreenUnlit.xml"));
-		gizmo->SetMaterial(2, cache->GetResource<Material>("Materials/Editor/BlueUnlit.xml"));
+		gizmo->SetModel(gizmoModels[EDIT_MOVE]);
+		for (unsigned i = 0; i < 3; ++i)
+			gizmo->SetMaterial(i, axisMaterials[i]);
 		gizmo->SetEnabled(false);
 		gizmo->SetViewMask(0x80000000); // Editor raycasts use viewmask 0x7fffffff
 		gizmo->SetOccludee(false);
 
+		gizmoPlaneGeometry = gizmoNode->CreateComponent<CustomGeometry>();
+		gizmoPlaneGeometry->SetNumGeometries(MAX_GIZMO_PLANES);
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			gizmoPlaneGeometry->SetMaterial(i, planeMaterials[i]);
+		gizmoPlaneGeometry->SetEnabled(false);
+		gizmoPlaneGeometry->SetViewMask(0x80000000);
+		gizmoPlaneGeometry->SetOccludee(false);
+
 		gizmoAxisX->lastSelected = false;
 		gizmoAxisY->lastSelected = false;
 		gizmoAxisZ->lastSelected = false;
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			gizmoPlanes[i]->lastSelected = false;
 		lastGizmoMode = EDIT_MOVE;
+		planesDirty_ = true;
+		hitTestValid_ = false;
+		previousGizmoDrag = false;
 	}
 
 	void GizmoScene3D::HideGizmo()
 	{
 		if (gizmo != NULL)
 			gizmo->SetEnabled(false);
+		if (gizmoPlaneGeometry != NULL)
+			gizmoPlaneGeometry->SetEnabled(false);
 	}
 
 	void GizmoScene3D::ShowGizmo()
@@ -74,8 +140,16 @@ namespace Urho3D
 
 			// Because setting enabled = false detaches the gizmo from octree,
 			// and it is a manually added drawable, must readd to octree when showing
-			if (editorData_->GetEditorScene()->GetComponent<Octree>() != NULL)
-				editorData_->GetEditorScene()->GetComponent<Octree>()->AddManualDrawable(gizmo);
+			Octree* octree = epScene3D_->GetRenderScene()->GetComponent<Octree>();
+			if (octree != NULL)
+				octree->AddManualDrawable(gizmo);
+
+			if (UsesPlaneHandles())
+			{
+				gizmoPlaneGeometry->SetEnabled(true);
+				if (octree != NULL)
+					octree->AddManualDrawable(gizmoPlaneGeometry);
+			}
 		}
 	}
 
@@ -90,54 +164,29 @@ namespace Urho3D
 	{
 		if (gizmo == NULL)
 			return;
-		ResourceCache* cache = GetSubsystem<ResourceCache>();
-		Vector3 center(0.0f, 0.0f, 0.0f);
-		bool containsScene = false;
-
-		for (unsigned int i = 0; i < editorSelection_->GetNumEditNodes(); ++i)
-		{
-			// Scene's transform should not be edited, so hide gizmo if it is included
-			if (editorSelection_->GetEditNodes()[i] == editorData_->GetEditorScene())
-			{
-				containsScene = true;
-				break;
-			}
-			center += editorSelection_->GetEditNodes()[i]->GetWorldPosition();
-		}
-
-		if (editorSelection_->GetEditNodes().Empty() || containsScene)
+		// Scene's transform should not be edited, so hide gizmo if it is included
+		if (editorSelection_->GetEditNodes().Empty() || epScene3D_->IsSceneEdited())
 		{
 			HideGizmo();
 			return;
 		}
 
-		center /= (float)editorSelection_->GetNumEditNodes();
-		gizmoNode->SetPosition(center);
-
-		if (epScene3D_->axisMode == AXIS_WORLD || editorSelection_->GetNumEditNodes() > 1)
-			gizmoNode->SetRotation(Quaternion());
-		else
-			gizmoNode->SetRotation(editorSelection_->GetEditNodes()[0]->GetWorldRotation());
+		// Outside a drag follow edits made elsewhere, e.g. in the inspector. The node positions are cheap to average every frame,
+		// the bounds center is only picked up again when the selection, the scene or an inspector attribute changes.
+		if (!previousGizmoDrag && epScene3D_->pivotMode != PIVOT_BOUNDS_CENTER)
+			epScene3D_->InvalidatePivot();
+		gizmoNode->SetPosition(epScene3D_->GetPivot());
+		gizmoNode->SetRotation(epScene3D_->GetGizmoRotation());
 
 		if (epScene3D_->editMode != lastGizmoMode)
 		{
-			switch (epScene3D_->editMode)
-			{
-			case EDIT_MOVE:
-				gizmo->SetModel(cache->GetResource<Model>("Models/Editor/Axes.mdl"));
-				break;
-
-			case EDIT_ROTATE:
-				gizmo->SetModel(cache->GetResource<Model>("Models/Editor/RotateAxes.mdl"));
-				break;
-
-			case EDIT_SCALE:
-				gizmo->SetModel(cache->GetResource<Model>("Models/Editor/ScaleAxes.mdl"));
-
-				break;
-			}
+			if (epScene3D_->editMode < EDIT_SELECT)
+				gizmo->SetModel(gizmoModels[epScene3D_->editMode]);
 
 			lastGizmoMode = epScene3D_->editMode;
+			// Hide to re-show with or without the plane handles, and pick again for the new handles
+			HideGizmo();
+			hitTestValid_ = false;
 		}
 
 		if ((epScene3D_->editMode != EDIT_SELECT && !epScene3D_->orbiting) && !gizmo->IsEnabled())
@@ -159,13 +208,74 @@ namespace Urho3D
 			scale *= (epScene3D_->camera_->GetView() * gizmoNode->GetPosition()).z_;
 
 		gizmoNode->SetScale(Vector3(scale, scale, scale));
+
+		if (gizmoPlaneGeometry->IsEnabled())
+			UpdateGizmoPlanes();
+	}
+
+	void GizmoScene3D::UpdateGizmoPlanes()
+	{
+		// The screen handle faces the camera, in gizmo space it changes with both rotations
+		Quaternion cameraRotation = gizmoNode->GetRotation().Inverse() * epScene3D_->cameraNode_->GetWorldRotation();
+		if (!planesDirty_ && cameraRotation.Equals(planeCameraRotation_))
+			return;
+
+		planeCameraRotation_ = cameraRotation;
+		planesDirty_ = false;
+
+		const Vector3 axes[3] = { Vector3::RIGHT, Vector3::UP, Vector3::FORWARD };
+		const unsigned planeAxes[3][2] = { { 0, 1 }, { 1, 2 }, { 0, 2 } };
+
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+		{
+			Vector3 corners[4];
+			if (i < GIZMO_PLANE_SCREEN)
+			{
+				const Vector3& axisU = axes[planeAxes[i][0]];
+				const Vector3& axisV = axes[planeAxes[i][1]];
+				corners[0] = axisU * planeMinExtent + axisV * planeMinExtent;
+				corners[1] = axisU * planeMaxExtent + axisV * planeMinExtent;
+				corners[2] = axisU * planeMaxExtent + axisV * planeMaxExtent;
+				corners[3] = axisU * planeMinExtent + axisV * planeMaxExtent;
+			}
+			else
+			{
+				Vector3 right = cameraRotation * Vector3::RIGHT * screenHandleSize;
+				Vector3 up = cameraRotation * Vector3::UP * screenHandleSize;
+				corners[0] = -right - up;
+				corners[1] = right - up;
+				corners[2] = right + up;
+				corners[3] = -right + up;
+			}
+
+			// Both windings, the handles are seen from either side
+			static const unsigned indices[] = { 0, 1, 2, 0, 2, 3, 0, 2, 1, 0, 3, 2 };
+			gizmoPlaneGeometry->BeginGeometry(i, TRIANGLE_LIST);
+			for (unsigned j = 0; j < 12; ++j)
+				gizmoPlaneGeometry->DefineVertex(corners[indices[j]]);
+		}
+		gizmoPlaneGeometry->Commit();
 	}
 
 	void GizmoScene3D::CalculateGizmoAxes()
 	{
-		gizmoAxisX->axisRay = Ray(gizmoNode->GetPosition(), gizmoNode->GetRotation() * Vector3(1, 0, 0));
-		gizmoAxisY->axisRay = Ray(gizmoNode->GetPosition(), gizmoNode->GetRotation() * Vector3(0, 1, 0));
-		gizmoAxisZ->axisRay = Ray(gizmoNode->GetPosition(), gizmoNode->GetRotation() * Vector3(0, 0, 1));
+		Vector3 origin = gizmoNode->GetPosition();
+		Quaternion rotation = gizmoNode->GetRotation();
+		gizmoAxisX->axisRay = Ray(origin, rotation * Vector3(1, 0, 0));
+		gizmoAxisY->axisRay = Ray(origin, rotation * Vector3(0, 1, 0));
+		gizmoAxisZ->axisRay = Ray(origin, rotation * Vector3(0, 0, 1));
+
+		gizmoPlanes[GIZMO_PLANE_XY]->axisU = gizmoAxisX->axisRay.direction_;
+		gizmoPlanes[GIZMO_PLANE_XY]->axisV = gizmoAxisY->axisRay.direction_;
+		gizmoPlanes[GIZMO_PLANE_YZ]->axisU = gizmoAxisY->axisRay.direction_;
+		gizmoPlanes[GIZMO_PLANE_YZ]->axisV = gizmoAxisZ->axisRay.direction_;
+		gizmoPlanes[GIZMO_PLANE_XZ]->axisU = gizmoAxisX->axisRay.direction_;
+		gizmoPlanes[GIZMO_PLANE_XZ]->axisV = gizmoAxisZ->axisRay.direction_;
+		Quaternion cameraRotation = epScene3D_->cameraNode_->GetWorldRotation();
+		gizmoPlanes[GIZMO_PLANE_SCREEN]->axisU = cameraRotation * Vector3::RIGHT;
+		gizmoPlanes[GIZMO_PLANE_SCREEN]->axisV = cameraRotation * Vector3::UP;
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			gizmoPlanes[i]->origin = origin;
 	}
 
 	void GizmoScene3D::GizmoMoved()
@@ -173,6 +283,36 @@ namespace Urho3D
 		gizmoAxisX->Moved();
 		gizmoAxisY->Moved();
 		gizmoAxisZ->Moved();
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			gizmoPlanes[i]->Moved();
+	}
+
+	bool GizmoScene3D::UsesPlaneHandles() const
+	{
+		return epScene3D_->editMode == EDIT_MOVE || epScene3D_->editMode == EDIT_SCALE;
+	}
+
+	void GizmoScene3D::UpdateGizmoMaterials()
+	{
+		GizmoAxis* axes[3] = { gizmoAxisX, gizmoAxisY, gizmoAxisZ };
+		for (unsigned i = 0; i < 3; ++i)
+		{
+			if (axes[i]->selected != axes[i]->lastSelected)
+			{
+				gizmo->SetMaterial(i, axes[i]->selected ? axisHighlightMaterials[i] : axisMaterials[i]);
+				axes[i]->lastSelected = axes[i]->selected;
+			}
+		}
+
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+		{
+			GizmoPlane* plane = gizmoPlanes[i];
+			if (plane->selected != plane->lastSelected)
+			{
+				gizmoPlaneGeometry->SetMaterial(i, plane->selected ? planeHighlightMaterials[i] : planeMaterials[i]);
+				plane->lastSelected = plane->selected;
+			}
+		}
 	}
 
 	void GizmoScene3D::UseGizmo()
@@ -191,6 +331,22 @@ namespace Urho3D
 		if (e != epScene3D_->activeView)
 			return;
 
+		Input* input = GetSubsystem<Input>();
+		bool drag = input->GetMouseButtonDown(MOUSEB_LEFT);
+
+		// Nothing to pick or drag while the cursor, the camera and the gizmo stay where they were
+		const Matrix3x4& cameraTransform = epScene3D_->cameraNode_->GetWorldTransform();
+		const Matrix3x4& gizmoTransform = gizmoNode->GetWorldTransform();
+		if (hitTestValid_ && pos == hitTestCursor_ && drag == hitTestDrag_ && cameraTransform == hitTestCamera_ &&
+			gizmoTransform == hitTestGizmo_)
+			return;
+
+		hitTestValid_ = true;
+		hitTestCursor_ = pos;
+		hitTestDrag_ = drag;
+		hitTestCamera_ = cameraTransform;
+		hitTestGizmo_ = gizmoTransform;
+
 		const IntVector2& screenpos = epScene3D_->activeView->GetScreenPosition();
 		float	posx = float(pos.x_ - screenpos.x_) / float(epScene3D_->activeView->GetWidth());
 		float	posy = float(pos.y_ - screenpos.y_) / float(epScene3D_->activeView->GetHeight());
@@ -198,31 +354,46 @@ namespace Urho3D
 		Ray cameraRay = epScene3D_->camera_->GetScreenRay(posx, posy);
 		float scale = gizmoNode->GetScale().x_;
 
-		Input* input = GetSubsystem<Input>();
 		// Recalculate axes only when not left-dragging
-		bool drag = input->GetMouseButtonDown(MOUSEB_LEFT);
 		if (!drag)
 			CalculateGizmoAxes();
 
 		gizmoAxisX->Update(cameraRay, scale, drag, epScene3D_->cameraNode_->GetPosition());
 		gizmoAxisY->Update(cameraRay, scale, drag, epScene3D_->cameraNode_->GetPosition());
 		gizmoAxisZ->Update(cameraRay, scale, drag, epScene3D_->cameraNode_->GetPosition());
-		ResourceCache* cache = GetSubsystem<ResourceCache>();
-		if (gizmoAxisX->selected != gizmoAxisX->lastSelected)
+
+		bool planeHandles = UsesPlaneHandles();
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
 		{
-			gizmo->SetMaterial(0, cache->GetResource<Material>(gizmoAxisX->selected ? "Materials/Editor/BrightRedUnlit.xml" : "Materials/Editor/RedUnlit.xml"));
-			gizmoAxisX->lastSelected = gizmoAxisX->selected;
+			if (planeHandles && i < GIZMO_PLANE_SCREEN)
+				gizmoPlanes[i]->Update(cameraRay, scale, drag, planeMinExtent, planeMaxExtent);
+			else if (planeHandles)
+				gizmoPlanes[i]->Update(cameraRay, scale, drag, -screenHandleSize, screenHandleSize);
+			else
+				gizmoPlanes[i]->selected = false;
 		}
-		if (gizmoAxisY->selected != gizmoAxisY->lastSelected)
+
+		// Only one kind of handle is grabbed, the screen handle sits on top of the axis origins
+		if (!drag)
 		{
-			gizmo->SetMaterial(1, cache->GetResource<Material>(gizmoAxisY->selected ? "Materials/Editor/BrightGreenUnlit.xml" : "Materials/Editor/GreenUnlit.xml"));
-			gizmoAxisY->lastSelected = gizmoAxisY->selected;
+			bool axisSelected = false;
+			if (gizmoPlanes[GIZMO_PLANE_SCREEN]->selected)
+			{
+				gizmoAxisX->selected = gizmoAxisY->selected = gizmoAxisZ->selected = false;
+			}
+			else
+				axisSelected = gizmoAxisX->selected || gizmoAxisY->selected || gizmoAxisZ->selected;
+
+			bool planeSelected = gizmoPlanes[GIZMO_PLANE_SCREEN]->selected;
+			for (unsigned i = 0; i < GIZMO_PLANE_SCREEN; ++i)
+			{
+				if (axisSelected || planeSelected)
+					gizmoPlanes[i]->selected = false;
+				planeSelected |= gizmoPlanes[i]->selected;
+			}
 		}
-		if (gizmoAxisZ->selected != gizmoAxisZ->lastSelected)
-		{
-			gizmo->SetMaterial(2, cache->GetResource<Material>(gizmoAxisZ->selected ? "Materials/Editor/BrightBlueUnlit.xml" : "Materials/Editor/BlueUnlit.xml"));
-			gizmoAxisZ->lastSelected = gizmoAxisZ->selected;
-		};
+
+		UpdateGizmoMaterials();
 
 		if (drag)
 		{
@@ -236,6 +407,19 @@ namespace Urho3D
 
 			bool moved = false;
 
+			// Movement in a plane handle, in gizmo space like the axis movement
+			Vector3 planeAdjust(0, 0, 0);
+			GizmoPlane* grabbedPlane = NULL;
+			for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			{
+				if (gizmoPlanes[i]->selected && gizmoPlanes[i]->hit)
+				{
+					grabbedPlane = gizmoPlanes[i];
+					planeAdjust = gizmoNode->GetRotation().Inverse() * (grabbedPlane->position - grabbedPlane->lastPosition);
+					break;
+				}
+			}
+
 			if (epScene3D_->editMode == EDIT_MOVE)
 			{
 				Vector3 adjust(0, 0, 0);
@@ -245,6 +429,7 @@ namespace Urho3D
 					adjust += Vector3(0, 1, 0) * (gizmoAxisY->t - gizmoAxisY->lastT);
 				if (gizmoAxisZ->selected)
 					adjust += Vector3(0, 0, 1) * (gizmoAxisZ->t - gizmoAxisZ->lastT);
+				adjust += planeAdjust;
 
 				moved = epScene3D_->MoveNodes(adjust);
 			}
@@ -277,6 +462,23 @@ namespace Urho3D
 					adjust = Vector3(x, x, x);
 				}
 
+				// A plane handle scales its two axes evenly, the screen handle all three by the horizontal movement
+				if (grabbedPlane == gizmoPlanes[GIZMO_PLANE_SCREEN])
+				{
+					float x = (grabbedPlane->position - grabbedPlane->lastPosition).DotProduct(grabbedPlane->axisU);
+					adjust = Vector3(x, x, x);
+				}
+				else if (grabbedPlane != NULL)
+				{
+					float x = (planeAdjust.x_ + planeAdjust.y_ + planeAdjust.z_) * 0.5f;
+					if (grabbedPlane == gizmoPlanes[GIZMO_PLANE_XY])
+						adjust = Vector3(x, x, 0.0f);
+					else if (grabbedPlane == gizmoPlanes[GIZMO_PLANE_YZ])
+						adjust = Vector3(0.0f, x, x);
+					else
+						adjust = Vector3(x, 0.0f, x);
+				}
+
 				moved = epScene3D_->ScaleNodes(adjust);
 			}
 
@@ -291,14 +493,23 @@ namespace Urho3D
 		{
 			// 			if (previousGizmoDrag)
 			// 				StoreGizmoEditActions();
+			// The pivot follows the drag, pick it up again from the edited nodes once it ends
+			if (previousGizmoDrag)
+				epScene3D_->InvalidatePivot();
 		}
 
-		/*		previousGizmoDrag = drag;*/
+		previousGizmoDrag = drag;
 	}
 
 	bool GizmoScene3D::IsGizmoSelected()
 	{
-		return gizmo != NULL && gizmo->IsEnabled() && (gizmoAxisX->selected || gizmoAxisY->selected || gizmoAxisZ->selected);
+		if (gizmo == NULL || !gizmo->IsEnabled())
+			return false;
+
+		bool planeSelected = false;
+		for (unsigned i = 0; i < MAX_GIZMO_PLANES; ++i)
+			planeSelected |= gizmoPlanes[i]->selected;
+		return gizmoAxisX->selected || gizmoAxisY->selected || gizmoAxisZ->selected || planeSelected;
 	}
 
 	GizmoAxis::GizmoAxis(Context* context) : Object(context)
@@ -350,4 +561,51 @@ namespace Urho3D
 		lastT = t;
 		lastD = d;
 	}
-}
\ No newline at end of file
+
+	GizmoPlane::GizmoPlane(Context* context) : Object(context)
+	{
+		selected = false;
+		lastSelected = false;
+		u = 0.0f;
+		v = 0.0f;
+		hit = false;
+	}
+
+	GizmoPlane::~GizmoPlane()
+	{
+	}
+
+	void GizmoPlane::Update(Ray cameraRay, float scale, bool drag, float minExtent, float maxExtent)
+	{
+		UI* ui = GetSubsystem<UI>();
+
+		// Do not select when UI has modal element
+		if (ui->HasModalElement())
+		{
+			selected = false;
+			return;
+		}
+
+		Plane plane(axisU.CrossProduct(axisV).Normalized(), origin);
+		float distance = cameraRay.HitDistance(plane);
+		hit = distance < M_INFINITY;
+		if (hit)
+		{
+			position = cameraRay.origin_ + cameraRay.direction_ * distance;
+			u = (position - origin).DotProduct(axisU);
+			v = (position - origin).DotProduct(axisV);
+		}
+
+		// Update selected status only when not dragging
+		if (!drag)
+		{
+			selected = hit && u >= minExtent * scale && u <= maxExtent * scale && v >= minExtent * scale && v <= maxExtent * scale;
+			lastPosition = position;
+		}
+	}
+
+	void GizmoPlane::Moved()
+	{
+		lastPosition = position;
+	}
+}
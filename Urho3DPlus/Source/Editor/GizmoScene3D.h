@@ -14,6 +14,9 @@ namespace Urho3D
 
 	class Node;
 	class StaticModel;
+	class CustomGeometry;
+	class Material;
+	class Model;
 	class Scene;
 	class EditorData;
 	class EditorSelection;
@@ -41,6 +44,47 @@ namespace Urho3D
 		float lastD;
 	};
 
+	/// handles of the gizmo that move or scale in a plane
+	enum GizmoPlaneHandle
+	{
+		GIZMO_PLANE_XY = 0,
+		GIZMO_PLANE_YZ,
+		GIZMO_PLANE_XZ,
+		/// plane facing the camera, grabbed at the gizmo center
+		GIZMO_PLANE_SCREEN,
+		MAX_GIZMO_PLANES
+	};
+
+	/// a square handle in the plane through origin spanned by axisU and axisV. Picked by intersecting the camera ray with the
+	/// plane, the same way GizmoAxis projects onto its axis.
+	class GizmoPlane : public Object
+	{
+		OBJECT(GizmoPlane);
+	public:
+		/// Construct.
+		GizmoPlane(Context* context);
+		/// Destruct.
+		virtual ~GizmoPlane();
+
+		/// the handle covers minExtent-maxExtent along both axes, scaled by the gizmo scale
+		void Update(Ray cameraRay, float scale, bool drag, float minExtent, float maxExtent);
+
+		void Moved();
+
+		Vector3 origin;
+		Vector3 axisU;
+		Vector3 axisV;
+		bool selected;
+		bool lastSelected;
+		/// plane coordinates of the cursor and the world point
+		float u;
+		float v;
+		Vector3 position;
+		Vector3 lastPosition;
+		/// false if the camera ray runs parallel to the plane
+		bool hit;
+	};
+
 
 	class GizmoScene3D : public Object
 	{
@@ -65,6 +109,13 @@ namespace Urho3D
 		void UseGizmo();
 		bool IsGizmoSelected();
 	protected:
+		/// rebuild the plane handle quads, the screen handle follows the camera
+		void UpdateGizmoPlanes();
+		/// swap to the highlighted materials of the handles whose selection changed
+		void UpdateGizmoMaterials();
+		/// plane handles are used by move and scale only
+		bool UsesPlaneHandles() const;
+
 		EditorData*			editorData_;
 		EditorSelection*	editorSelection_;
 
@@ -75,9 +126,26 @@ namespace Urho3D
 		SharedPtr<GizmoAxis> gizmoAxisX;
 		SharedPtr<GizmoAxis> gizmoAxisY;
 		SharedPtr<GizmoAxis> gizmoAxisZ;
+		SharedPtr<GizmoPlane> gizmoPlanes[MAX_GIZMO_PLANES];
+		SharedPtr<CustomGeometry> gizmoPlaneGeometry;
 		EPScene3D* epScene3D_;
+		/// resources resolved once on creation: models per edit mode, axis and plane materials plain and highlighted
+		SharedPtr<Model> gizmoModels[EDIT_SELECT];
+		SharedPtr<Material> axisMaterials[3];
+		SharedPtr<Material> axisHighlightMaterials[3];
+		SharedPtr<Material> planeMaterials[MAX_GIZMO_PLANES];
+		SharedPtr<Material> planeHighlightMaterials[MAX_GIZMO_PLANES];
+		/// state of the last hit test, it's skipped while none of it changes
+		IntVector2 hitTestCursor_;
+		Matrix3x4 hitTestCamera_;
+		Matrix3x4 hitTestGizmo_;
+		bool hitTestDrag_;
+		bool hitTestValid_;
+		/// camera rotation the screen handle was built for
+		Quaternion planeCameraRotation_;
+		bool planesDirty_;
+		bool previousGizmoDrag;
 		// For undo
-// 		bool previousGizmoDrag;
 // 		bool needGizmoUndo;
 // 		Array<Transform> oldGizmoTransforms;
 	};
@@ -0,0 +1,376 @@
+#include "../Urho3D.h"
+#include "HandleOverlay.h"
+#include "../Core/Context.h"
+#include "../Scene/Scene.h"
+#include "../Scene/Component.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Octree.h"
+#include "../Graphics/CustomGeometry.h"
+#include "../Graphics/BillboardSet.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Texture2D.h"
+#include "../Graphics/Light.h"
+#include "../Graphics/Zone.h"
+#include "../Physics/CollisionShape.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/XMLFile.h"
+
+namespace Urho3D
+{
+	/// segments of a circle in the wire shapes
+	static const unsigned HANDLE_CIRCLE_SEGMENTS = 24;
+
+	static const char* handleIconNames[MAX_HANDLE_ICONS] =
+	{
+		"Light",
+		"Zone",
+		"CollisionShape"
+	};
+
+	HandleOverlay::HandleOverlay(Context* context) : Object(context),
+		maxHandles_(2048),
+		iconSize_(0.04f),
+		iconsDirty_(true),
+		visible_(false)
+	{
+		for (unsigned i = 0; i < MAX_HANDLE_ICONS; ++i)
+			iconUVs_[i] = Rect(0.0f, 0.0f, 1.0f, 1.0f);
+		BuildShapes();
+	}
+
+	HandleOverlay::~HandleOverlay()
+	{
+		Hide();
+	}
+
+	void HandleOverlay::Create(XMLFile* iconStyle)
+	{
+		ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+		node_ = new Node(context_);
+		lines_ = node_->CreateComponent<CustomGeometry>();
+		lines_->SetNumGeometries(1);
+		lines_->SetMaterial(cache->GetResource<Material>("Materials/VColUnlit.xml"));
+		lines_->SetViewMask(0x80000000); // Editor raycasts use viewmask 0x7fffffff
+		lines_->SetOccludee(false);
+		lines_->SetEnabled(false);
+
+		Texture2D* iconTexture = cache->GetResource<Texture2D>("Textures/Editor/EditorIcons.png");
+		SharedPtr<Material> iconMaterial;
+		Material* texturedUnlit = cache->GetResource<Material>("Materials/Editor/TexturedUnlit.xml");
+		if (texturedUnlit != NULL)
+		{
+			iconMaterial = texturedUnlit->Clone();
+			iconMaterial->SetTexture(TU_DIFFUSE, iconTexture);
+		}
+
+		icons_ = node_->CreateComponent<BillboardSet>();
+		icons_->SetMaterial(iconMaterial);
+		icons_->SetRelative(false);
+		icons_->SetScaled(false);
+		icons_->SetSorted(false);
+		icons_->SetViewMask(0x80000000);
+		icons_->SetOccludee(false);
+		icons_->SetEnabled(false);
+
+		// The icons are the ones of the hierarchy window, taken from the same style
+		if (iconStyle != NULL && iconTexture != NULL && iconTexture->GetWidth() > 0 && iconTexture->GetHeight() > 0)
+		{
+			Vector2 invSize(1.0f / (float)iconTexture->GetWidth(), 1.0f / (float)iconTexture->GetHeight());
+			for (XMLElement element = iconStyle->GetRoot().GetChild("element"); element; element = element.GetNext("element"))
+			{
+				String type = element.GetAttribute("type");
+				for (unsigned i = 0; i < MAX_HANDLE_ICONS; ++i)
+				{
+					if (type != handleIconNames[i])
+						continue;
+
+					for (XMLElement attribute = element.GetChild("attribute"); attribute; attribute = attribute.GetNext("attribute"))
+					{
+						if (attribute.GetAttribute("name") != "Image Rect")
+							continue;
+						IntRect rect = attribute.GetIntRect("value");
+						iconUVs_[i] = Rect(rect.left_ * invSize.x_, rect.top_ * invSize.y_, rect.right_ * invSize.x_, rect.bottom_ * invSize.y_);
+					}
+				}
+			}
+		}
+
+		iconsDirty_ = true;
+	}
+
+	bool HandleOverlay::IsHandleComponent(Component* component)
+	{
+		if (component == NULL)
+			return false;
+		StringHash type = component->GetType();
+		return type == Light::GetTypeStatic() || type == Zone::GetTypeStatic() || type == CollisionShape::GetTypeStatic();
+	}
+
+	void HandleOverlay::BeginHandles()
+	{
+		instances_.Clear();
+	}
+
+	bool HandleOverlay::AddHandle(Component* component)
+	{
+		Node* node = component->GetNode();
+		if (node == NULL || !IsHandleComponent(component))
+			return false;
+
+		StringHash type = component->GetType();
+		if (type == Light::GetTypeStatic())
+		{
+			Light* light = static_cast<Light*>(component);
+			Color color = light->GetColor();
+			color.a_ = 1.0f;
+			Vector3 position = node->GetWorldPosition();
+			Quaternion rotation = node->GetWorldRotation();
+
+			if (light->GetLightType() == LIGHT_DIRECTIONAL)
+				AddInstance(Matrix3x4(position, rotation, 2.0f), color, HANDLE_SHAPE_ARROW, HANDLE_ICON_LIGHT);
+			else if (light->GetLightType() == LIGHT_SPOT)
+			{
+				float range = light->GetRange();
+				float radius = range * Tan(light->GetFov() * 0.5f);
+				AddInstance(Matrix3x4(position, rotation, Vector3(radius * light->GetAspectRatio(), radius, range)), color,
+					HANDLE_SHAPE_CONE, HANDLE_ICON_LIGHT);
+			}
+			else
+				AddInstance(Matrix3x4(position, rotation, light->GetRange() * 2.0f), color, HANDLE_SHAPE_SPHERE, HANDLE_ICON_LIGHT);
+		}
+		else if (type == Zone::GetTypeStatic())
+		{
+			const BoundingBox& box = static_cast<Zone*>(component)->GetBoundingBox();
+			AddInstance(node->GetWorldTransform() * Matrix3x4(box.Center(), Quaternion::IDENTITY, box.Size()), Color::GREEN,
+				HANDLE_SHAPE_BOX, HANDLE_ICON_ZONE);
+		}
+		else
+		{
+			// The node scale applies to collision shapes too
+			CollisionShape* shape = static_cast<CollisionShape*>(component);
+			const Vector3& size = shape->GetSize();
+			Matrix3x4 transform = node->GetWorldTransform() * Matrix3x4(shape->GetPosition(), shape->GetRotation(), Vector3::ONE);
+			Color color(0.0f, 1.0f, 1.0f);
+
+			switch (shape->GetShapeType())
+			{
+			case SHAPE_BOX:
+				AddInstance(transform * Matrix3x4(Vector3::ZERO, Quaternion::IDENTITY, size), color, HANDLE_SHAPE_BOX, HANDLE_ICON_COLLISIONSHAPE);
+				break;
+
+			case SHAPE_SPHERE:
+				AddInstance(transform * Matrix3x4(Vector3::ZERO, Quaternion::IDENTITY, size.x_), color, HANDLE_SHAPE_SPHERE, HANDLE_ICON_COLLISIONSHAPE);
+				break;
+
+			case SHAPE_CYLINDER:
+			case SHAPE_CAPSULE:
+				// A capsule is drawn as the cylinder around it
+				AddInstance(transform * Matrix3x4(Vector3::ZERO, Quaternion::IDENTITY, Vector3(size.x_, size.y_, size.x_)), color,
+					HANDLE_SHAPE_CYLINDER, HANDLE_ICON_COLLISIONSHAPE);
+				break;
+
+			case SHAPE_CONE:
+				// Along the Y axis with the apex on top
+				AddInstance(transform * Matrix3x4(Vector3(0.0f, size.y_ * 0.5f, 0.0f), Quaternion(90.0f, Vector3::RIGHT),
+					Vector3(size.x_ * 0.5f, size.x_ * 0.5f, size.y_)), color, HANDLE_SHAPE_CONE, HANDLE_ICON_COLLISIONSHAPE);
+				break;
+
+			default:
+				// Meshes, hulls and terrains keep their own debug geometry
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool HandleOverlay::EndHandles(Scene* scene, Camera* camera)
+	{
+		bool changed = instances_.Size() != lastInstances_.Size();
+		for (unsigned i = 0; i < instances_.Size() && !changed; ++i)
+		{
+			if (instances_[i] != lastInstances_[i])
+				changed = true;
+		}
+
+		if (changed)
+		{
+			lastInstances_ = instances_;
+			UpdateGeometry();
+			iconsDirty_ = true;
+		}
+
+		Octree* octree = scene != NULL ? scene->GetComponent<Octree>() : NULL;
+		SetVisible(octree, !lastInstances_.Empty());
+		if (visible_ && camera != NULL && UpdateIcons(camera))
+			changed = true;
+
+		return changed;
+	}
+
+	void HandleOverlay::Hide()
+	{
+		SetVisible(NULL, false);
+	}
+
+	void HandleOverlay::AddInstance(const Matrix3x4& transform, const Color& color, HandleShape shape, HandleIcon icon)
+	{
+		if (IsFull())
+			return;
+
+		HandleInstance instance;
+		instance.transform_ = transform;
+		instance.color_ = color;
+		instance.shape_ = shape;
+		instance.icon_ = icon;
+		instances_.Push(instance);
+	}
+
+	void HandleOverlay::BuildShapes()
+	{
+		// Box
+		PODVector<Vector3>& box = shapes_[HANDLE_SHAPE_BOX];
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			float x = (i & 1) ? 0.5f : -0.5f;
+			float y = (i & 2) ? 0.5f : -0.5f;
+			// Edges along Z, then the ones along X and Y at both ends
+			box.Push(Vector3(x, y, -0.5f));
+			box.Push(Vector3(x, y, 0.5f));
+			box.Push(Vector3(-0.5f, x, y));
+			box.Push(Vector3(0.5f, x, y));
+			box.Push(Vector3(y, -0.5f, x));
+			box.Push(Vector3(y, 0.5f, x));
+		}
+
+		// Sphere
+		PODVector<Vector3>& sphere = shapes_[HANDLE_SHAPE_SPHERE];
+		AddCircle(sphere, Vector3::ZERO, Vector3::RIGHT, Vector3::UP, 0.5f);
+		AddCircle(sphere, Vector3::ZERO, Vector3::UP, Vector3::FORWARD, 0.5f);
+		AddCircle(sphere, Vector3::ZERO, Vector3::RIGHT, Vector3::FORWARD, 0.5f);
+
+		// Cylinder
+		PODVector<Vector3>& cylinder = shapes_[HANDLE_SHAPE_CYLINDER];
+		AddCircle(cylinder, Vector3(0.0f, -0.5f, 0.0f), Vector3::RIGHT, Vector3::FORWARD, 0.5f);
+		AddCircle(cylinder, Vector3(0.0f, 0.5f, 0.0f), Vector3::RIGHT, Vector3::FORWARD, 0.5f);
+		const Vector3 sides[4] = { Vector3::RIGHT, Vector3::LEFT, Vector3::FORWARD, Vector3::BACK };
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			cylinder.Push(sides[i] * 0.5f + Vector3(0.0f, -0.5f, 0.0f));
+			cylinder.Push(sides[i] * 0.5f + Vector3(0.0f, 0.5f, 0.0f));
+		}
+
+		// Cone
+		PODVector<Vector3>& cone = shapes_[HANDLE_SHAPE_CONE];
+		AddCircle(cone, Vector3::FORWARD, Vector3::RIGHT, Vector3::UP, 1.0f);
+		const Vector3 edges[4] = { Vector3::RIGHT, Vector3::LEFT, Vector3::UP, Vector3::DOWN };
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			cone.Push(Vector3::ZERO);
+			cone.Push(edges[i] + Vector3::FORWARD);
+		}
+
+		// Arrow
+		PODVector<Vector3>& arrow = shapes_[HANDLE_SHAPE_ARROW];
+		arrow.Push(Vector3::ZERO);
+		arrow.Push(Vector3::FORWARD);
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			arrow.Push(Vector3::FORWARD);
+			arrow.Push(Vector3(0.0f, 0.0f, 0.8f) + edges[i] * 0.1f);
+		}
+	}
+
+	void HandleOverlay::AddCircle(PODVector<Vector3>& lines, const Vector3& center, const Vector3& axisU, const Vector3& axisV, float radius)
+	{
+		Vector3 last = center + axisU * radius;
+		for (unsigned i = 1; i <= HANDLE_CIRCLE_SEGMENTS; ++i)
+		{
+			float angle = 360.0f * (float)i / (float)HANDLE_CIRCLE_SEGMENTS;
+			Vector3 point = center + (axisU * Cos(angle) + axisV * Sin(angle)) * radius;
+			lines.Push(last);
+			lines.Push(point);
+			last = point;
+		}
+	}
+
+	void HandleOverlay::UpdateGeometry()
+	{
+		if (lines_ == NULL)
+			return;
+
+		lines_->BeginGeometry(0, LINE_LIST);
+		for (unsigned i = 0; i < lastInstances_.Size(); ++i)
+		{
+			const HandleInstance& instance = lastInstances_[i];
+			const PODVector<Vector3>& shape = shapes_[instance.shape_];
+			for (unsigned j = 0; j < shape.Size(); ++j)
+			{
+				lines_->DefineVertex(instance.transform_ * shape[j]);
+				lines_->DefineColor(instance.color_);
+			}
+		}
+		lines_->Commit();
+	}
+
+	bool HandleOverlay::UpdateIcons(Camera* camera)
+	{
+		if (icons_ == NULL)
+			return false;
+
+		// The icons keep their size on screen, they only change with the handles and the camera
+		const Matrix3x4& cameraTransform = camera->GetNode()->GetWorldTransform();
+		if (!iconsDirty_ && cameraTransform == iconCameraTransform_)
+			return false;
+		iconsDirty_ = false;
+		iconCameraTransform_ = cameraTransform;
+
+		Matrix3x4 view = camera->GetView();
+		float viewHeight = camera->IsOrthographic() ? camera->GetOrthoSize() : 2.0f * Tan(camera->GetFov() * 0.5f);
+		float size = iconSize_ * viewHeight / camera->GetZoom();
+
+		icons_->SetNumBillboards(lastInstances_.Size());
+		for (unsigned i = 0; i < lastInstances_.Size(); ++i)
+		{
+			const HandleInstance& instance = lastInstances_[i];
+			Billboard* billboard = icons_->GetBillboard(i);
+			billboard->position_ = instance.transform_.Translation();
+
+			float depth = camera->IsOrthographic() ? 1.0f : (view * billboard->position_).z_;
+			billboard->enabled_ = depth > 0.0f;
+			billboard->size_ = Vector2::ONE * (size * depth * 0.5f);
+			billboard->uv_ = iconUVs_[instance.icon_];
+			billboard->color_ = Color::WHITE;
+			billboard->rotation_ = 0.0f;
+		}
+		icons_->Commit();
+		return true;
+	}
+
+	void HandleOverlay::SetVisible(Octree* octree, bool visible)
+	{
+		if (lines_ == NULL || icons_ == NULL)
+			return;
+		if (visible == visible_ && (!visible || octree == octree_.Get()))
+			return;
+
+		// Manual drawables leave the octree when disabled and have to be added again when shown
+		if (octree_ != NULL)
+		{
+			octree_->RemoveManualDrawable(lines_);
+			octree_->RemoveManualDrawable(icons_);
+		}
+		lines_->SetEnabled(visible);
+		icons_->SetEnabled(visible);
+		if (visible && octree != NULL)
+		{
+			octree->AddManualDrawable(lines_);
+			octree->AddManualDrawable(icons_);
+		}
+
+		visible_ = visible;
+		octree_ = visible ? octree : (Octree*)NULL;
+		iconsDirty_ = true;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Container/Ptr.h"
+#include "../Math/Matrix3x4.h"
+#include "../Math/Color.h"
+#include "../Math/Rect.h"
+#include "../Scene/Node.h"
+#include "Utils/Macros.h"
+
+namespace Urho3D
+{
+	class Component;
+	class Scene;
+	class Camera;
+	class Octree;
+	class CustomGeometry;
+	class BillboardSet;
+	class XMLFile;
+
+	/// unit wire shapes the handles are made of
+	enum HandleShape
+	{
+		/// cube from -0.5 to 0.5
+		HANDLE_SHAPE_BOX = 0,
+		/// three circles of diameter 1
+		HANDLE_SHAPE_SPHERE,
+		/// diameter 1 and height 1 along the Y axis
+		HANDLE_SHAPE_CYLINDER,
+		/// apex at the origin, base of radius 1 at Z = 1
+		HANDLE_SHAPE_CONE,
+		/// from the origin to Z = 1
+		HANDLE_SHAPE_ARROW,
+		MAX_HANDLE_SHAPES
+	};
+
+	/// icons shown at the handles
+	enum HandleIcon
+	{
+		HANDLE_ICON_LIGHT = 0,
+		HANDLE_ICON_ZONE,
+		HANDLE_ICON_COLLISIONSHAPE,
+		MAX_HANDLE_ICONS
+	};
+
+	/// draws the handles of the selected lights, zones and collision shapes. Every handle is a unit shape with a transform, all
+	/// of them go into one line geometry and one billboard set, so the whole overlay is two draw calls. The geometry is only
+	/// rebuilt when a handle changed and never holds more than maxHandles_ handles.
+	class HandleOverlay : public Object
+	{
+		OBJECT(HandleOverlay);
+	public:
+		/// Construct.
+		HandleOverlay(Context* context);
+		/// Destruct.
+		virtual ~HandleOverlay();
+
+		/// create the drawables, the icons are looked up by component type in the icon style
+		void Create(XMLFile* iconStyle);
+		/// true for the components whose handle the overlay draws instead of their debug geometry
+		static bool IsHandleComponent(Component* component);
+
+		/// start collecting the handles of a frame
+		void BeginHandles();
+		/// add the handle of the component. Returns false if the overlay can not draw it, handles over the limit are dropped.
+		bool AddHandle(Component* component);
+		/// rebuild the drawables if the handles changed and keep them in the octree of the scene. Returns true if the
+		/// overlay changed and the views need an update.
+		bool EndHandles(Scene* scene, Camera* camera);
+		void Hide();
+		/// true when more handles would be dropped
+		bool IsFull() const { return instances_.Size() >= maxHandles_; }
+
+		U_PROPERTY_IMP(unsigned, maxHandles_, MaxHandles)
+		/// icon size relative to the view height
+		U_PROPERTY_IMP(float, iconSize_, IconSize)
+
+	protected:
+		struct HandleInstance
+		{
+			bool operator ==(const HandleInstance& rhs) const
+			{
+				return shape_ == rhs.shape_ && icon_ == rhs.icon_ && color_ == rhs.color_ && transform_ == rhs.transform_;
+			}
+			bool operator !=(const HandleInstance& rhs) const { return !(*this == rhs); }
+
+			Matrix3x4 transform_;
+			Color color_;
+			HandleShape shape_;
+			HandleIcon icon_;
+		};
+
+		void AddInstance(const Matrix3x4& transform, const Color& color, HandleShape shape, HandleIcon icon);
+		void BuildShapes();
+		void AddCircle(PODVector<Vector3>& lines, const Vector3& center, const Vector3& axisU, const Vector3& axisV, float radius);
+		void UpdateGeometry();
+		bool UpdateIcons(Camera* camera);
+		void SetVisible(Octree* octree, bool visible);
+
+		SharedPtr<Node> node_;
+		SharedPtr<CustomGeometry> lines_;
+		SharedPtr<BillboardSet> icons_;
+		/// octree the drawables were added to
+		WeakPtr<Octree> octree_;
+		/// line list of every unit shape
+		PODVector<Vector3> shapes_[MAX_HANDLE_SHAPES];
+		Rect iconUVs_[MAX_HANDLE_ICONS];
+		/// handles of this and the last frame, the geometry is rebuilt when they differ
+		PODVector<HandleInstance> instances_;
+		PODVector<HandleInstance> lastInstances_;
+		/// camera transform the icons were sized for
+		Matrix3x4 iconCameraTransform_;
+		bool iconsDirty_;
+		bool visible_;
+	};
+}
@@ -462,7 +462,7 @@ namespace Urho3D
 			// Cannot multi-edit on scene and node(s) together as scene and node do not share identical attributes,
 			// editing via gizmo does not make too much sense either
 			if (editorData_->GetEditNodes().Size() > 1 && editorData_->GetEditNodes()[0] == scene_)
-				editorData_->GetEditNodes().Erase(0);
+				editorData_->RemoveEditNode(scene_);
 		}
 
 		if (editorData_->GetSelectedUIElements().Empty() && editorData_->GetEditUIElement() != NULL)
@@ -0,0 +1,102 @@
+#include "../Urho3D.h"
+#include "PrefabCache.h"
+#include "../Core/Context.h"
+#include "../Scene/Scene.h"
+#include "../Resource/XMLFile.h"
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/Log.h"
+
+namespace Urho3D
+{
+	PrefabCache::PrefabCache(Context* context) : Object(context)
+	{
+	}
+
+	PrefabCache::~PrefabCache()
+	{
+	}
+
+	Node* PrefabCache::Instantiate(Scene* scene, const String& fileName, const Vector3& position, const Quaternion& rotation, CreateMode mode /*= REPLICATED*/)
+	{
+		if (scene == NULL)
+			return NULL;
+
+		Prefab* prefab = GetPrefab(fileName);
+		if (prefab == NULL)
+			return NULL;
+
+		if (prefab->xmlFile_)
+			return scene->InstantiateXML(prefab->xmlFile_->GetRoot(), position, rotation, mode);
+
+		// Scene::Instantiate() reads the node id first, same as from the file
+		MemoryBuffer buffer(prefab->data_.Get(), prefab->dataSize_);
+		return scene->Instantiate(buffer, position, rotation, mode);
+	}
+
+	bool PrefabCache::Load(const String& fileName)
+	{
+		return GetPrefab(fileName) != NULL;
+	}
+
+	void PrefabCache::Remove(const String& fileName)
+	{
+		prefabs_.Erase(fileName);
+	}
+
+	void PrefabCache::Clear()
+	{
+		prefabs_.Clear();
+	}
+
+	PrefabCache::Prefab* PrefabCache::GetPrefab(const String& fileName)
+	{
+		if (fileName.Empty())
+			return NULL;
+
+		FileSystem* fileSystem = GetSubsystem<FileSystem>();
+		unsigned modifiedTime = fileSystem->GetLastModifiedTime(fileName);
+
+		HashMap<String, Prefab>::Iterator i = prefabs_.Find(fileName);
+		if (i != prefabs_.End() && i->second_.modifiedTime_ == modifiedTime)
+			return &i->second_;
+
+		File file(context_);
+		if (!file.Open(fileName, FILE_READ))
+		{
+			prefabs_.Erase(fileName);
+			return NULL;
+		}
+
+		Prefab prefab;
+		prefab.modifiedTime_ = modifiedTime;
+		prefab.dataSize_ = 0;
+
+		if (GetExtension(fileName) == ".xml")
+		{
+			prefab.xmlFile_ = new XMLFile(context_);
+			if (!prefab.xmlFile_->Load(file))
+			{
+				LOGERROR("Could not parse node file " + fileName);
+				prefabs_.Erase(fileName);
+				return NULL;
+			}
+		}
+		else
+		{
+			prefab.dataSize_ = file.GetSize();
+			prefab.data_ = new unsigned char[prefab.dataSize_];
+			if (file.Read(prefab.data_.Get(), prefab.dataSize_) != prefab.dataSize_)
+			{
+				LOGERROR("Could not read node file " + fileName);
+				prefabs_.Erase(fileName);
+				return NULL;
+			}
+		}
+
+		Prefab& entry = prefabs_[fileName];
+		entry = prefab;
+		return &entry;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Container/HashMap.h"
+#include "../Container/ArrayPtr.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+	class Scene;
+	class XMLFile;
+
+	/// parsed node files for repeated instantiation. Entries are keyed by file name and reloaded when the file changes on disk.
+	class PrefabCache : public Object
+	{
+		OBJECT(PrefabCache);
+	public:
+		/// Construct.
+		PrefabCache(Context* context);
+		/// Destruct.
+		virtual ~PrefabCache();
+
+		/// instantiate the node file into the scene, the file is read and parsed only on first use or after it changed.
+		Node* Instantiate(Scene* scene, const String& fileName, const Vector3& position, const Quaternion& rotation, CreateMode mode = REPLICATED);
+		/// load the file if it's not cached or out of date. Returns false if it could not be read.
+		bool Load(const String& fileName);
+		/// forget one file.
+		void Remove(const String& fileName);
+		/// forget all files.
+		void Clear();
+
+	protected:
+		struct Prefab
+		{
+			/// modification time of the file when it was read
+			unsigned modifiedTime_;
+			/// node data of a binary file
+			SharedArrayPtr<unsigned char> data_;
+			unsigned dataSize_;
+			/// parsed xml file
+			SharedPtr<XMLFile> xmlFile_;
+		};
+
+		Prefab* GetPrefab(const String& fileName);
+
+		HashMap<String, Prefab> prefabs_;
+	};
+}
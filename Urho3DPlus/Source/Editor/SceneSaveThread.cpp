@@ -0,0 +1,186 @@
+#include "../Urho3D.h"
+#include "SceneSaveThread.h"
+#include "../Core/Context.h"
+#include "../Scene/Scene.h"
+#include "../Resource/XMLFile.h"
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
+#include "../IO/Log.h"
+
+#include <cstdio>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+namespace Urho3D
+{
+	/// replace destFileName with srcFileName in one step, so the destination is never left half written.
+	static bool ReplaceFile(const String& srcFileName, const String& destFileName)
+	{
+#ifdef WIN32
+		return MoveFileExW(GetWideNativePath(srcFileName).CString(), GetWideNativePath(destFileName).CString(),
+			MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		return rename(GetNativePath(srcFileName).CString(), GetNativePath(destFileName).CString()) == 0;
+#endif
+	}
+
+	SceneSaveThread::SceneSaveThread(Context* context) : Object(context),
+		current_(0),
+		queued_(false),
+		saving_(false),
+		finished_(false),
+		success_(false)
+	{
+	}
+
+	SceneSaveThread::~SceneSaveThread()
+	{
+		bool success;
+		String fileName;
+		// Finish the running save, then write the queued one
+		Stop();
+		if (PollFinished(success, fileName) && queued_)
+			Stop();
+	}
+
+	bool SceneSaveThread::Save(Scene* scene, const String& fileName)
+	{
+		if (scene == NULL || fileName.Empty())
+			return false;
+
+		// The running or unpolled save keeps its slot and its result, this one waits for it
+		bool busy;
+		{
+			MutexLock lock(mutex_);
+			busy = saving_ || finished_;
+		}
+		if (!busy)
+		{
+			if (!Capture(scene, fileName, current_))
+				return false;
+			Start();
+			return true;
+		}
+
+		if (queued_)
+		{
+			LOGERROR("Can not save " + fileName + ", a scene save is queued already");
+			return false;
+		}
+		queued_ = Capture(scene, fileName, 1 - current_);
+		return queued_;
+	}
+
+	bool SceneSaveThread::IsSaving()
+	{
+		MutexLock lock(mutex_);
+		return saving_ || queued_;
+	}
+
+	bool SceneSaveThread::PollFinished(bool& success, String& fileName)
+	{
+		{
+			MutexLock lock(mutex_);
+			if (!finished_)
+				return false;
+			finished_ = false;
+			success = success_;
+		}
+
+		Stop();
+		fileName = fileNames_[current_];
+		xmlFiles_[current_].Reset();
+
+		if (queued_)
+		{
+			queued_ = false;
+			current_ = 1 - current_;
+			Start();
+		}
+		return true;
+	}
+
+	bool SceneSaveThread::Capture(Scene* scene, const String& fileName, unsigned slot)
+	{
+		VectorBuffer& buffer = buffers_[slot];
+		SharedPtr<XMLFile>& xmlFile = xmlFiles_[slot];
+		fileNames_[slot] = fileName;
+		buffer.Clear();
+		xmlFile.Reset();
+
+		// Capture on the main thread, the scene is free to change as soon as this returns
+		bool captured;
+		if (GetExtension(fileName) != ".xml")
+			captured = scene->Save(buffer);
+		else
+		{
+			xmlFile = new XMLFile(context_);
+			XMLElement root = xmlFile->CreateRoot("scene");
+			// Scene::SaveXML would format the document here, the worker does that instead
+			captured = scene->Node::SaveXML(root);
+		}
+
+		if (!captured)
+			xmlFile.Reset();
+		return captured;
+	}
+
+	void SceneSaveThread::Start()
+	{
+		{
+			MutexLock lock(mutex_);
+			saving_ = true;
+			finished_ = false;
+			success_ = false;
+		}
+
+		if (!Run())
+		{
+			// Could not start the worker, write on this thread instead
+			ThreadFunction();
+		}
+	}
+
+	void SceneSaveThread::ThreadFunction()
+	{
+		VectorBuffer& buffer = buffers_[current_];
+		const String& fileName = fileNames_[current_];
+		if (xmlFiles_[current_])
+		{
+			buffer.Clear();
+			xmlFiles_[current_]->Save(buffer);
+		}
+
+		String tempFileName = fileName + ".tmp";
+		bool success = false;
+		{
+			File file(context_);
+			if (file.Open(tempFileName, FILE_WRITE))
+			{
+				success = file.Write(buffer.GetData(), buffer.GetSize()) == buffer.GetSize();
+				file.Close();
+			}
+		}
+
+		if (success)
+			success = ReplaceFile(tempFileName, fileName);
+
+		if (!success)
+		{
+			// Do not leave a partial file behind
+#ifdef WIN32
+			DeleteFileW(GetWideNativePath(tempFileName).CString());
+#else
+			remove(GetNativePath(tempFileName).CString());
+#endif
+			LOGERROR("Could not write scene file " + fileName);
+		}
+
+		MutexLock lock(mutex_);
+		saving_ = false;
+		finished_ = true;
+		success_ = success;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Core/Thread.h"
+#include "../Core/Mutex.h"
+#include "../IO/VectorBuffer.h"
+
+namespace Urho3D
+{
+	class Scene;
+	class XMLFile;
+
+	/// writes a scene snapshot to disk on a worker thread. The snapshot is captured on the main thread, the worker only
+	/// formats and writes it to a temporary file which then atomically replaces the destination file. A save requested
+	/// while another one is running or not yet polled is captured and queued, it starts when the previous one is polled.
+	class SceneSaveThread : public Object, public Thread
+	{
+		OBJECT(SceneSaveThread);
+	public:
+		/// Construct.
+		SceneSaveThread(Context* context);
+		/// Destruct. Waits for a running save to finish and writes the queued one.
+		virtual ~SceneSaveThread();
+
+		/// capture the scene and start writing it to fileName, xml or binary by extension. Returns false if the capture
+		/// failed or a save is queued already.
+		bool Save(Scene* scene, const String& fileName);
+		/// return true while the worker is writing or a save is queued.
+		bool IsSaving();
+		/// if the running save has finished, join the worker, start the queued save and return true. success and fileName
+		/// are set to the result and destination of the finished save.
+		bool PollFinished(bool& success, String& fileName);
+
+		/// Worker thread function.
+		virtual void ThreadFunction();
+
+	protected:
+		/// capture the scene into a slot
+		bool Capture(Scene* scene, const String& fileName, unsigned slot);
+		/// start the worker on the current slot
+		void Start();
+
+		/// captured binary scene data of the running and the queued save, reused between saves
+		VectorBuffer buffers_[2];
+		/// captured xml scenes, formatted by the worker
+		SharedPtr<XMLFile> xmlFiles_[2];
+		String fileNames_[2];
+		/// slot of the running save, the other one holds the queued save
+		unsigned current_;
+		bool queued_;
+		Mutex mutex_;
+		bool saving_;
+		bool finished_;
+		bool success_;
+	};
+}
@@ -0,0 +1,214 @@
+#include "../Urho3D.h"
+#include "SceneSnapshot.h"
+#include "../Core/Context.h"
+#include "../Scene/Scene.h"
+#include "../Scene/Node.h"
+#include "../Scene/Component.h"
+#include "../Scene/Serializable.h"
+#include "../IO/Log.h"
+
+namespace Urho3D
+{
+	SceneSnapshot::SceneSnapshot(Context* context) : Object(context),
+		numRestored_(0)
+	{
+	}
+
+	SceneSnapshot::~SceneSnapshot()
+	{
+	}
+
+	void SceneSnapshot::Clear()
+	{
+		data_.Clear();
+		nodes_.Clear();
+		components_.Clear();
+		nodeIds_.Clear();
+		componentIds_.Clear();
+	}
+
+	void SceneSnapshot::Take(Scene* scene)
+	{
+		Clear();
+		if (scene == NULL)
+			return;
+
+		TakeNode(scene);
+	}
+
+	void SceneSnapshot::TakeNode(Node* node)
+	{
+		NodeEntry entry;
+		entry.id_ = node->GetID();
+		entry.parentId_ = node->GetParent() ? node->GetParent()->GetID() : 0;
+		entry.offset_ = data_.GetPosition();
+		nodes_.Push(entry);
+		nodeIds_.Insert(entry.id_);
+		WriteAttributes(node);
+
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			Component* component = components[i];
+			ComponentEntry compEntry;
+			compEntry.id_ = component->GetID();
+			compEntry.nodeId_ = entry.id_;
+			compEntry.type_ = component->GetType();
+			compEntry.offset_ = data_.GetPosition();
+			components_.Push(compEntry);
+			componentIds_.Insert(compEntry.id_);
+			WriteAttributes(component);
+		}
+
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned i = 0; i < children.Size(); ++i)
+			TakeNode(children[i]);
+	}
+
+	void SceneSnapshot::WriteAttributes(Serializable* serializable)
+	{
+		const Vector<AttributeInfo>* attributes = serializable->GetAttributes();
+		if (!attributes)
+			return;
+
+		for (unsigned i = 0; i < attributes->Size(); ++i)
+		{
+			if (attributes->At(i).mode_ & AM_FILE)
+				data_.WriteVariantData(serializable->GetAttribute(i));
+		}
+	}
+
+	bool SceneSnapshot::RestoreAttributes(Serializable* serializable, unsigned offset)
+	{
+		const Vector<AttributeInfo>* attributes = serializable->GetAttributes();
+		if (!attributes)
+			return false;
+
+		data_.Seek(offset);
+		bool changed = false;
+		for (unsigned i = 0; i < attributes->Size(); ++i)
+		{
+			const AttributeInfo& attr = attributes->At(i);
+			if (!(attr.mode_ & AM_FILE))
+				continue;
+
+			Variant value = data_.ReadVariant(attr.type_);
+			if (value != serializable->GetAttribute(i))
+			{
+				serializable->SetAttribute(i, value);
+				changed = true;
+			}
+		}
+
+		if (changed)
+			changed_.Push(serializable);
+		return changed;
+	}
+
+	void SceneSnapshot::RemoveAddedNodes(Node* node)
+	{
+		// Collect first, removing while iterating would invalidate the child vector
+		PODVector<Node*> addedNodes;
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned i = 0; i < children.Size(); ++i)
+		{
+			if (!nodeIds_.Contains(children[i]->GetID()))
+				addedNodes.Push(children[i]);
+			else
+				RemoveAddedNodes(children[i]);
+		}
+
+		for (unsigned i = 0; i < addedNodes.Size(); ++i)
+			node->RemoveChild(addedNodes[i]);
+
+		PODVector<Component*> addedComponents;
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			if (!componentIds_.Contains(components[i]->GetID()))
+				addedComponents.Push(components[i]);
+		}
+
+		for (unsigned i = 0; i < addedComponents.Size(); ++i)
+			node->RemoveComponent(addedComponents[i]);
+	}
+
+	bool SceneSnapshot::Restore(Scene* scene)
+	{
+		numRestored_ = 0;
+		if (scene == NULL || nodes_.Empty())
+			return false;
+
+		if (scene->GetID() != nodes_[0].id_)
+		{
+			LOGERROR("Scene snapshot does not belong to this scene");
+			return false;
+		}
+
+		RemoveAddedNodes(scene);
+		Apply(scene);
+		return true;
+	}
+
+	bool SceneSnapshot::CopyTo(Scene* scene)
+	{
+		numRestored_ = 0;
+		if (scene == NULL || nodes_.Empty())
+			return false;
+
+		// A cleared scene has nothing to remove, every object is recreated and only non-default attributes are set
+		scene->Clear();
+		Apply(scene);
+		return true;
+	}
+
+	void SceneSnapshot::Apply(Scene* scene)
+	{
+		changed_.Clear();
+
+		// Nodes are stored parents first, so a removed parent is always recreated before its children
+		for (unsigned i = 0; i < nodes_.Size(); ++i)
+		{
+			const NodeEntry& entry = nodes_[i];
+			Node* node = i == 0 ? scene : scene->GetNode(entry.id_);
+			if (i > 0)
+			{
+				Node* parent = scene->GetNode(entry.parentId_);
+				if (parent == NULL)
+					continue;
+
+				if (node == NULL)
+					node = parent->CreateChild(String::EMPTY, entry.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, entry.id_);
+				else if (node->GetParent() != parent)
+					node->SetParent(parent);
+			}
+
+			RestoreAttributes(node, entry.offset_);
+		}
+
+		for (unsigned i = 0; i < components_.Size(); ++i)
+		{
+			const ComponentEntry& entry = components_[i];
+			Component* component = scene->GetComponent(entry.id_);
+			if (component == NULL)
+			{
+				Node* node = scene->GetNode(entry.nodeId_);
+				if (node == NULL)
+					continue;
+
+				component = node->CreateComponent(entry.type_, entry.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL, entry.id_);
+				if (component == NULL)
+					continue;
+			}
+
+			RestoreAttributes(component, entry.offset_);
+		}
+
+		// Apply once everything is in place, attributes may refer to other nodes or components
+		for (unsigned i = 0; i < changed_.Size(); ++i)
+			changed_[i]->ApplyAttributes();
+
+		numRestored_ = changed_.Size();
+		changed_.Clear();
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Container/HashSet.h"
+#include "../IO/VectorBuffer.h"
+
+namespace Urho3D
+{
+	class Scene;
+	class Node;
+	class Serializable;
+
+	/// binary in-memory snapshot of a scene, restored by rewriting only what changed since it was taken.
+	class SceneSnapshot : public Object
+	{
+		OBJECT(SceneSnapshot);
+	public:
+		/// Construct.
+		SceneSnapshot(Context* context);
+		/// Destruct.
+		virtual ~SceneSnapshot();
+
+		/// snapshot the file attributes of all nodes and components. The data buffer is reused between snapshots.
+		void Take(Scene* scene);
+		/// revert the scene to the snapshot: removes added objects, recreates removed ones and rewrites changed attributes only.
+		bool Restore(Scene* scene);
+		/// rebuild the snapshot in another scene, which is cleared first. Nodes and components keep their ids.
+		bool CopyTo(Scene* scene);
+		/// release the snapshot, keeps the buffer capacity.
+		void Clear();
+
+		bool IsEmpty() const { return nodes_.Empty(); }
+		/// return the number of objects whose attributes were rewritten by the last restore.
+		unsigned GetNumRestored() const { return numRestored_; }
+
+	protected:
+		struct NodeEntry
+		{
+			unsigned id_;
+			unsigned parentId_;
+			unsigned offset_;
+		};
+
+		struct ComponentEntry
+		{
+			unsigned id_;
+			unsigned nodeId_;
+			StringHash type_;
+			unsigned offset_;
+		};
+
+		void TakeNode(Node* node);
+		void WriteAttributes(Serializable* serializable);
+		/// read the attributes at offset and set those that differ, returns true if any were changed.
+		bool RestoreAttributes(Serializable* serializable, unsigned offset);
+		void RemoveAddedNodes(Node* node);
+		/// create missing objects and rewrite changed attributes
+		void Apply(Scene* scene);
+
+		/// attribute data of all nodes and components
+		VectorBuffer data_;
+		/// nodes in depth-first order, parents always precede their children
+		PODVector<NodeEntry> nodes_;
+		PODVector<ComponentEntry> components_;
+		HashSet<unsigned> nodeIds_;
+		HashSet<unsigned> componentIds_;
+		/// objects changed during restore, attributes are applied once all are loaded
+		Vector<Serializable*> changed_;
+		unsigned numRestored_;
+	};
+}
@@ -0,0 +1,341 @@
+#include "../Urho3D.h"
+#include "SelectionSets.h"
+#include "../Core/Context.h"
+#include "../Scene/Scene.h"
+#include "../Scene/Component.h"
+#include "../Scene/SceneEvents.h"
+#include "../Graphics/Drawable.h"
+#include "../Graphics/Material.h"
+#include "../Resource/ResourceCache.h"
+#include "../IO/VectorBuffer.h"
+#include "../IO/MemoryBuffer.h"
+
+namespace Urho3D
+{
+	static const String SELECTION_SETS_VAR_NAME("EditorSelectionSets");
+	static const String SELECTION_QUERIES_VAR_NAME("EditorSelectionQueries");
+	/// list of sets, each one a VariantVector of name, node ID buffer and component ID buffer
+	static const StringHash SELECTION_SETS_VAR(SELECTION_SETS_VAR_NAME);
+	/// list of queries, each one a VariantVector of name, component type, material, center and radius
+	static const StringHash SELECTION_QUERIES_VAR(SELECTION_QUERIES_VAR_NAME);
+
+	static const PODVector<Component*> NO_COMPONENTS;
+
+	SelectionSets::SelectionSets(Context* context) : Object(context)
+	{
+	}
+
+	SelectionSets::~SelectionSets()
+	{
+	}
+
+	void SelectionSets::SetScene(Scene* scene)
+	{
+		if (scene_)
+		{
+			UnsubscribeFromEvent(scene_, E_NODEADDED);
+			UnsubscribeFromEvent(scene_, E_NODEREMOVED);
+			UnsubscribeFromEvent(scene_, E_COMPONENTADDED);
+			UnsubscribeFromEvent(scene_, E_COMPONENTREMOVED);
+		}
+
+		scene_ = scene;
+		components_.Clear();
+		positions_.Clear();
+		if (!scene)
+			return;
+
+		scene->RegisterVar(SELECTION_SETS_VAR_NAME);
+		scene->RegisterVar(SELECTION_QUERIES_VAR_NAME);
+		IndexNode(scene, true);
+
+		SubscribeToEvent(scene, E_NODEADDED, HANDLER(SelectionSets, HandleNodeAdded));
+		SubscribeToEvent(scene, E_NODEREMOVED, HANDLER(SelectionSets, HandleNodeRemoved));
+		SubscribeToEvent(scene, E_COMPONENTADDED, HANDLER(SelectionSets, HandleComponentAdded));
+		SubscribeToEvent(scene, E_COMPONENTREMOVED, HANDLER(SelectionSets, HandleComponentRemoved));
+	}
+
+	void SelectionSets::StoreSet(const String& name, const Vector<Node*>& nodes, const Vector<Component*>& components)
+	{
+		if (!scene_ || name.Empty())
+			return;
+
+		VectorBuffer nodeIDs;
+		for (unsigned i = 0; i < nodes.Size(); ++i)
+			nodeIDs.WriteVLE(nodes[i]->GetID());
+		VectorBuffer componentIDs;
+		for (unsigned i = 0; i < components.Size(); ++i)
+			componentIDs.WriteVLE(components[i]->GetID());
+
+		VariantVector entry;
+		entry.Push(name);
+		entry.Push(nodeIDs.GetBuffer());
+		entry.Push(componentIDs.GetBuffer());
+		SetEntry(SELECTION_SETS_VAR, name, entry);
+	}
+
+	bool SelectionSets::GetSet(const String& name, PODVector<Node*>& nodes, PODVector<Component*>& components) const
+	{
+		nodes.Clear();
+		components.Clear();
+		if (!scene_)
+			return false;
+
+		const VariantVector& entries = scene_->GetVar(SELECTION_SETS_VAR).GetVariantVector();
+		unsigned index = FindEntry(entries, name);
+		if (index == M_MAX_UNSIGNED)
+			return false;
+
+		const VariantVector& entry = entries[index].GetVariantVector();
+		if (entry.Size() < 3)
+			return false;
+
+		const PODVector<unsigned char>& nodeIDs = entry[1].GetBuffer();
+		MemoryBuffer nodeBuffer(nodeIDs.Size() ? &nodeIDs[0] : (const void*)0, nodeIDs.Size());
+		while (!nodeBuffer.IsEof())
+		{
+			Node* node = scene_->GetNode(nodeBuffer.ReadVLE());
+			if (node)
+				nodes.Push(node);
+		}
+
+		const PODVector<unsigned char>& componentIDs = entry[2].GetBuffer();
+		MemoryBuffer componentBuffer(componentIDs.Size() ? &componentIDs[0] : (const void*)0, componentIDs.Size());
+		while (!componentBuffer.IsEof())
+		{
+			Component* component = scene_->GetComponent(componentBuffer.ReadVLE());
+			if (component)
+				components.Push(component);
+		}
+		return true;
+	}
+
+	void SelectionSets::RemoveSet(const String& name)
+	{
+		SetEntry(SELECTION_SETS_VAR, name, Variant::emptyVariantVector);
+	}
+
+	Vector<String> SelectionSets::GetSetNames() const
+	{
+		Vector<String> names;
+		if (!scene_)
+			return names;
+
+		const VariantVector& entries = scene_->GetVar(SELECTION_SETS_VAR).GetVariantVector();
+		for (unsigned i = 0; i < entries.Size(); ++i)
+		{
+			const VariantVector& entry = entries[i].GetVariantVector();
+			if (!entry.Empty())
+				names.Push(entry[0].GetString());
+		}
+		return names;
+	}
+
+	void SelectionSets::StoreQuery(const SelectionQuery& query)
+	{
+		if (!scene_ || query.name_.Empty())
+			return;
+
+		VariantVector entry;
+		entry.Push(query.name_);
+		entry.Push(query.componentType_);
+		entry.Push(query.material_);
+		entry.Push(query.center_);
+		entry.Push(query.radius_);
+		SetEntry(SELECTION_QUERIES_VAR, query.name_, entry);
+	}
+
+	bool SelectionSets::GetQuery(const String& name, SelectionQuery& query) const
+	{
+		if (!scene_)
+			return false;
+
+		const VariantVector& entries = scene_->GetVar(SELECTION_QUERIES_VAR).GetVariantVector();
+		unsigned index = FindEntry(entries, name);
+		if (index == M_MAX_UNSIGNED)
+			return false;
+
+		const VariantVector& entry = entries[index].GetVariantVector();
+		if (entry.Size() < 5)
+			return false;
+
+		query.name_ = entry[0].GetString();
+		query.componentType_ = entry[1].GetString();
+		query.material_ = entry[2].GetString();
+		query.center_ = entry[3].GetVector3();
+		query.radius_ = entry[4].GetFloat();
+		return true;
+	}
+
+	void SelectionSets::RemoveQuery(const String& name)
+	{
+		SetEntry(SELECTION_QUERIES_VAR, name, Variant::emptyVariantVector);
+	}
+
+	Vector<String> SelectionSets::GetQueryNames() const
+	{
+		Vector<String> names;
+		if (!scene_)
+			return names;
+
+		const VariantVector& entries = scene_->GetVar(SELECTION_QUERIES_VAR).GetVariantVector();
+		for (unsigned i = 0; i < entries.Size(); ++i)
+		{
+			const VariantVector& entry = entries[i].GetVariantVector();
+			if (!entry.Empty())
+				names.Push(entry[0].GetString());
+		}
+		return names;
+	}
+
+	void SelectionSets::RunQuery(const SelectionQuery& query, PODVector<Component*>& result) const
+	{
+		result.Clear();
+
+		const PODVector<Component*>& candidates = GetComponents(StringHash(query.componentType_));
+		if (candidates.Empty())
+			return;
+
+		// Materials are compared by pointer, a material that is not loaded is not used by anything
+		Material* material = NULL;
+		if (!query.material_.Empty())
+		{
+			material = GetSubsystem<ResourceCache>()->GetExistingResource<Material>(query.material_);
+			if (!material)
+				return;
+		}
+		float radiusSquared = query.radius_ * query.radius_;
+
+		for (unsigned i = 0; i < candidates.Size(); ++i)
+		{
+			Component* component = candidates[i];
+			if (query.radius_ > 0.0f && (component->GetNode()->GetWorldPosition() - query.center_).LengthSquared() > radiusSquared)
+				continue;
+
+			if (material)
+			{
+				Drawable* drawable = dynamic_cast<Drawable*>(component);
+				if (!drawable)
+					continue;
+
+				const Vector<SourceBatch>& batches = drawable->GetBatches();
+				bool found = false;
+				for (unsigned j = 0; j < batches.Size() && !found; ++j)
+					found = batches[j].material_ == material;
+				if (!found)
+					continue;
+			}
+
+			result.Push(component);
+		}
+	}
+
+	const PODVector<Component*>& SelectionSets::GetComponents(StringHash type) const
+	{
+		HashMap<StringHash, PODVector<Component*> >::ConstIterator i = components_.Find(type);
+		return i != components_.End() ? i->second_ : NO_COMPONENTS;
+	}
+
+	void SelectionSets::AddComponent(Component* component)
+	{
+		if (positions_.Contains(component))
+			return;
+
+		PODVector<Component*>& components = components_[component->GetType()];
+		positions_[component] = components.Size();
+		components.Push(component);
+	}
+
+	void SelectionSets::RemoveComponent(Component* component)
+	{
+		HashMap<Component*, unsigned>::Iterator i = positions_.Find(component);
+		if (i == positions_.End())
+			return;
+
+		// Move the last component of the type into the freed slot
+		PODVector<Component*>& components = components_[component->GetType()];
+		Component* last = components.Back();
+		components[i->second_] = last;
+		positions_[last] = i->second_;
+		components.Pop();
+		positions_.Erase(component);
+	}
+
+	void SelectionSets::IndexNode(Node* node, bool add)
+	{
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			if (add)
+				AddComponent(components[i]);
+			else
+				RemoveComponent(components[i]);
+		}
+
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned i = 0; i < children.Size(); ++i)
+			IndexNode(children[i], add);
+	}
+
+	unsigned SelectionSets::FindEntry(const VariantVector& entries, const String& name) const
+	{
+		for (unsigned i = 0; i < entries.Size(); ++i)
+		{
+			const VariantVector& entry = entries[i].GetVariantVector();
+			if (!entry.Empty() && entry[0].GetString() == name)
+				return i;
+		}
+		return M_MAX_UNSIGNED;
+	}
+
+	void SelectionSets::SetEntry(StringHash var, const String& name, const VariantVector& entry)
+	{
+		if (!scene_)
+			return;
+
+		VariantVector entries = scene_->GetVar(var).GetVariantVector();
+		unsigned index = FindEntry(entries, name);
+		if (entry.Empty())
+		{
+			if (index == M_MAX_UNSIGNED)
+				return;
+			entries.Erase(index);
+		}
+		else if (index == M_MAX_UNSIGNED)
+			entries.Push(entry);
+		else
+			entries[index] = entry;
+
+		scene_->SetVar(var, entries);
+	}
+
+	void SelectionSets::HandleNodeAdded(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace NodeAdded;
+
+		// A node can arrive with its components and children, e.g. when it is moved over from another scene
+		IndexNode(static_cast<Node*>(eventData[P_NODE].GetPtr()), true);
+	}
+
+	void SelectionSets::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace NodeRemoved;
+
+		// The components of a removed node do not send their own removal events
+		IndexNode(static_cast<Node*>(eventData[P_NODE].GetPtr()), false);
+	}
+
+	void SelectionSets::HandleComponentAdded(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ComponentAdded;
+
+		AddComponent(static_cast<Component*>(eventData[P_COMPONENT].GetPtr()));
+	}
+
+	void SelectionSets::HandleComponentRemoved(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ComponentRemoved;
+
+		RemoveComponent(static_cast<Component*>(eventData[P_COMPONENT].GetPtr()));
+	}
+}
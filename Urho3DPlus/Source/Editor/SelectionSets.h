@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Container/HashMap.h"
+#include "../Math/Vector3.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+	class Scene;
+	class Component;
+
+	/// a saved query: the components of one type, optionally only those using a material and those within a radius
+	struct SelectionQuery
+	{
+		SelectionQuery() :
+			center_(Vector3::ZERO),
+			radius_(0.0f)
+		{
+		}
+
+		String name_;
+		/// component type name
+		String componentType_;
+		/// material resource name, empty for any material
+		String material_;
+		Vector3 center_;
+		/// 0 for no limit
+		float radius_;
+	};
+
+	/// named selection sets and saved queries of a scene. Both are stored in scene variables, the sets as compact ID lists,
+	/// so they are saved and loaded with the scene. Queries run against a component type index that follows the scene
+	/// changes instead of walking the scene.
+	class SelectionSets : public Object
+	{
+		OBJECT(SelectionSets);
+	public:
+		/// Construct.
+		SelectionSets(Context* context);
+		/// Destruct.
+		virtual ~SelectionSets();
+
+		/// index the components of the scene and follow its changes
+		void SetScene(Scene* scene);
+		Scene* GetScene() const { return scene_; }
+
+		/// store the nodes and components under name, replacing a set of the same name
+		void StoreSet(const String& name, const Vector<Node*>& nodes, const Vector<Component*>& components);
+		/// resolve the set IDs, objects that no longer exist are skipped. Returns false if there is no such set.
+		bool GetSet(const String& name, PODVector<Node*>& nodes, PODVector<Component*>& components) const;
+		void RemoveSet(const String& name);
+		Vector<String> GetSetNames() const;
+
+		/// store the query under its name, replacing a query of the same name
+		void StoreQuery(const SelectionQuery& query);
+		bool GetQuery(const String& name, SelectionQuery& query) const;
+		void RemoveQuery(const String& name);
+		Vector<String> GetQueryNames() const;
+		/// components matching the query
+		void RunQuery(const SelectionQuery& query, PODVector<Component*>& result) const;
+
+		/// indexed components of a type
+		const PODVector<Component*>& GetComponents(StringHash type) const;
+
+	protected:
+		void AddComponent(Component* component);
+		void RemoveComponent(Component* component);
+		/// add or remove the components of node and its children
+		void IndexNode(Node* node, bool add);
+		/// entry of name in the stored list, or M_MAX_UNSIGNED
+		unsigned FindEntry(const VariantVector& entries, const String& name) const;
+		void SetEntry(StringHash var, const String& name, const VariantVector& entry);
+
+		void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
+		void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
+		void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
+		void HandleComponentRemoved(StringHash eventType, VariantMap& eventData);
+
+		WeakPtr<Scene> scene_;
+		/// components per type, and the position of each component in its type list
+		HashMap<StringHash, PODVector<Component*> > components_;
+		HashMap<Component*, unsigned> positions_;
+	};
+}
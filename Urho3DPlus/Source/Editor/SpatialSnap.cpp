@@ -0,0 +1,335 @@
+#include "../Urho3D.h"
+#include "SpatialSnap.h"
+#include "../Core/Context.h"
+#include "../Scene/Scene.h"
+#include "../Graphics/Drawable.h"
+#include "../Graphics/StaticModel.h"
+#include "../Graphics/Model.h"
+#include "../Graphics/VertexBuffer.h"
+#include "../Graphics/Octree.h"
+#include "../Graphics/OctreeQuery.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Container/Sort.h"
+#include "../Math/Sphere.h"
+#include "../Math/Ray.h"
+
+namespace Urho3D
+{
+	/// most points in a leaf of a vertex hierarchy
+	static const unsigned BVH_LEAF_SIZE = 8;
+
+	static bool ComparePointX(const Vector3& lhs, const Vector3& rhs) { return lhs.x_ < rhs.x_; }
+	static bool ComparePointY(const Vector3& lhs, const Vector3& rhs) { return lhs.y_ < rhs.y_; }
+	static bool ComparePointZ(const Vector3& lhs, const Vector3& rhs) { return lhs.z_ < rhs.z_; }
+
+	static float BoxDistanceSquared(const BoundingBox& box, const Vector3& point)
+	{
+		Vector3 d(Max(Max(box.min_.x_ - point.x_, 0.0f), point.x_ - box.max_.x_),
+			Max(Max(box.min_.y_ - point.y_, 0.0f), point.y_ - box.max_.y_),
+			Max(Max(box.min_.z_ - point.z_, 0.0f), point.z_ - box.max_.z_));
+		return d.LengthSquared();
+	}
+
+	SpatialSnap::SpatialSnap(Context* context) : Object(context)
+	{
+	}
+
+	SpatialSnap::~SpatialSnap()
+	{
+	}
+
+	Vector3 SpatialSnap::Snap(SpatialSnapMode mode, Octree* octree, Node* node, const Vector3& position, const Vector<Node*>& excluded, float maxDistance)
+	{
+		if (mode == SPATIAL_SNAP_NONE || octree == NULL || node == NULL)
+			return position;
+
+		// The bounds where the node would be
+		BoundingBox bounds = GetNodeBounds(node);
+		Vector3 offset = position - node->GetWorldPosition();
+		bounds.min_ += offset;
+		bounds.max_ += offset;
+
+		switch (mode)
+		{
+		case SPATIAL_SNAP_SURFACE:
+			return SnapToSurface(octree, bounds, position, excluded);
+
+		case SPATIAL_SNAP_VERTEX:
+			return SnapToVertex(octree, position, excluded, maxDistance);
+
+		case SPATIAL_SNAP_BOUNDS:
+			return SnapToBounds(octree, bounds, position, excluded, maxDistance);
+
+		default:
+			return position;
+		}
+	}
+
+	BoundingBox SpatialSnap::GetNodeBounds(Node* node)
+	{
+		BoundingBox bounds;
+		if (node == NULL)
+			return bounds;
+
+		MergeNodeBounds(node, bounds);
+		if (!bounds.defined_)
+			bounds.Merge(node->GetWorldPosition());
+		return bounds;
+	}
+
+	void SpatialSnap::Clear()
+	{
+		vertexBVHs_.Clear();
+	}
+
+	Vector3 SpatialSnap::SnapToSurface(Octree* octree, const BoundingBox& bounds, const Vector3& position, const Vector<Node*>& excluded)
+	{
+		// Cast down from the top of the bounds, so a surface the node already sinks into is found too
+		Vector3 center = bounds.Center();
+		Ray ray(Vector3(center.x_, bounds.max_.y_, center.z_), Vector3::DOWN);
+
+		PODVector<RayQueryResult> results;
+		RayOctreeQuery query(results, ray, RAY_TRIANGLE, M_INFINITY, DRAWABLE_GEOMETRY);
+		octree->Raycast(query);
+
+		// Results are sorted by distance
+		for (unsigned i = 0; i < results.Size(); ++i)
+		{
+			if (IsExcluded(octree, results[i].drawable_, excluded))
+				continue;
+
+			return position + Vector3(0.0f, results[i].position_.y_ - bounds.min_.y_, 0.0f);
+		}
+
+		return position;
+	}
+
+	Vector3 SpatialSnap::SnapToVertex(Octree* octree, const Vector3& position, const Vector<Node*>& excluded, float maxDistance)
+	{
+		SphereOctreeQuery query(drawables_, Sphere(position, maxDistance), DRAWABLE_GEOMETRY);
+		octree->GetDrawables(query);
+
+		Vector3 best = position;
+		float bestDistSquared = maxDistance * maxDistance;
+
+		for (unsigned i = 0; i < drawables_.Size(); ++i)
+		{
+			if (IsExcluded(octree, drawables_[i], excluded))
+				continue;
+
+			StaticModel* staticModel = dynamic_cast<StaticModel*>(drawables_[i]);
+			if (staticModel == NULL || staticModel->GetModel() == NULL)
+				continue;
+
+			VertexBVH* bvh = GetVertexBVH(staticModel->GetModel());
+			if (bvh == NULL || bvh->nodes_.Empty())
+				continue;
+
+			Node* node = staticModel->GetNode();
+			Vector3 scale = node->GetWorldScale();
+			float minScale = Min(Min(Abs(scale.x_), Abs(scale.y_)), Abs(scale.z_));
+			if (minScale < M_EPSILON)
+				continue;
+
+			// Search in model space. Scaled by the smallest axis scale the limit covers every vertex within reach in world space.
+			const Matrix3x4& transform = node->GetWorldTransform();
+			Vector3 localPosition = transform.Inverse() * position;
+			float localDistSquared = bestDistSquared / (minScale * minScale);
+			float startDistSquared = localDistSquared;
+			Vector3 localBest;
+			FindNearest(*bvh, 0, localPosition, localBest, localDistSquared);
+			if (localDistSquared >= startDistSquared)
+				continue;
+
+			Vector3 worldBest = transform * localBest;
+			float distSquared = (worldBest - position).LengthSquared();
+			if (distSquared < bestDistSquared)
+			{
+				best = worldBest;
+				bestDistSquared = distSquared;
+			}
+		}
+
+		return best;
+	}
+
+	Vector3 SpatialSnap::SnapToBounds(Octree* octree, const BoundingBox& bounds, const Vector3& position, const Vector<Node*>& excluded, float maxDistance)
+	{
+		Vector3 reach(maxDistance, maxDistance, maxDistance);
+		BoxOctreeQuery query(drawables_, BoundingBox(bounds.min_ - reach, bounds.max_ + reach), DRAWABLE_GEOMETRY);
+		octree->GetDrawables(query);
+
+		const float* min = bounds.min_.Data();
+		const float* max = bounds.max_.Data();
+		float snap[3] = { 0.0f, 0.0f, 0.0f };
+		float bestDistance[3] = { maxDistance, maxDistance, maxDistance };
+
+		// Each axis snaps on its own to the closest face pair: side by side or flush
+		for (unsigned i = 0; i < drawables_.Size(); ++i)
+		{
+			if (IsExcluded(octree, drawables_[i], excluded))
+				continue;
+
+			const BoundingBox& other = drawables_[i]->GetWorldBoundingBox();
+			const float* otherMin = other.min_.Data();
+			const float* otherMax = other.max_.Data();
+			for (unsigned axis = 0; axis < 3; ++axis)
+			{
+				float deltas[4] = {
+					otherMin[axis] - max[axis],
+					otherMax[axis] - min[axis],
+					otherMin[axis] - min[axis],
+					otherMax[axis] - max[axis]
+				};
+				for (unsigned j = 0; j < 4; ++j)
+				{
+					if (Abs(deltas[j]) < bestDistance[axis])
+					{
+						bestDistance[axis] = Abs(deltas[j]);
+						snap[axis] = deltas[j];
+					}
+				}
+			}
+		}
+
+		return position + Vector3(snap[0], snap[1], snap[2]);
+	}
+
+	bool SpatialSnap::IsExcluded(Octree* octree, Drawable* drawable, const Vector<Node*>& excluded) const
+	{
+		Node* node = drawable != NULL ? drawable->GetNode() : NULL;
+		if (node == NULL || node->GetScene() != octree->GetScene())
+			return true;
+
+		for (unsigned i = 0; i < excluded.Size(); ++i)
+		{
+			if (node == excluded[i] || node->IsChildOf(excluded[i]))
+				return true;
+		}
+		return false;
+	}
+
+	void SpatialSnap::MergeNodeBounds(Node* node, BoundingBox& bounds) const
+	{
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			Drawable* drawable = dynamic_cast<Drawable*>(components[i].Get());
+			if (drawable != NULL && (drawable->GetDrawableFlags() & DRAWABLE_GEOMETRY))
+				bounds.Merge(drawable->GetWorldBoundingBox());
+		}
+
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned i = 0; i < children.Size(); ++i)
+			MergeNodeBounds(children[i], bounds);
+	}
+
+	SpatialSnap::VertexBVH* SpatialSnap::GetVertexBVH(Model* model)
+	{
+		HashMap<Model*, VertexBVH>::Iterator i = vertexBVHs_.Find(model);
+		if (i != vertexBVHs_.End() && i->second_.model_.Get() == model)
+			return &i->second_;
+
+		VertexBVH& bvh = vertexBVHs_[model];
+		bvh.model_ = model;
+		BuildVertexBVH(bvh, model);
+		SubscribeToEvent(model, E_RELOADFINISHED, HANDLER(SpatialSnap, HandleModelReloaded));
+		return &bvh;
+	}
+
+	void SpatialSnap::BuildVertexBVH(VertexBVH& bvh, Model* model)
+	{
+		bvh.points_.Clear();
+		bvh.nodes_.Clear();
+
+		// Models keep a CPU copy of their vertices, the position is always the first element
+		const Vector<SharedPtr<VertexBuffer> >& buffers = model->GetVertexBuffers();
+		for (unsigned i = 0; i < buffers.Size(); ++i)
+		{
+			VertexBuffer* buffer = buffers[i];
+			const unsigned char* data = buffer != NULL ? buffer->GetShadowData() : NULL;
+			if (data == NULL || !(buffer->GetElementMask() & MASK_POSITION))
+				continue;
+
+			unsigned vertexSize = buffer->GetVertexSize();
+			unsigned vertexCount = buffer->GetVertexCount();
+			for (unsigned j = 0; j < vertexCount; ++j)
+				bvh.points_.Push(*reinterpret_cast<const Vector3*>(data + j * vertexSize));
+		}
+
+		if (!bvh.points_.Empty())
+			BuildBVHNode(bvh, 0, bvh.points_.Size());
+	}
+
+	unsigned SpatialSnap::BuildBVHNode(VertexBVH& bvh, unsigned start, unsigned count)
+	{
+		unsigned index = bvh.nodes_.Size();
+		bvh.nodes_.Resize(index + 1);
+
+		BoundingBox box;
+		for (unsigned i = start; i < start + count; ++i)
+			box.Merge(bvh.points_[i]);
+
+		BVHNode& node = bvh.nodes_[index];
+		node.box_ = box;
+		node.start_ = start;
+		node.count_ = count;
+		node.right_ = 0;
+
+		if (count <= BVH_LEAF_SIZE)
+			return index;
+
+		// Split at the median of the longest axis
+		Vector3 size = box.Size();
+		if (size.x_ >= size.y_ && size.x_ >= size.z_)
+			Sort(bvh.points_.Begin() + start, bvh.points_.Begin() + start + count, ComparePointX);
+		else if (size.y_ >= size.z_)
+			Sort(bvh.points_.Begin() + start, bvh.points_.Begin() + start + count, ComparePointY);
+		else
+			Sort(bvh.points_.Begin() + start, bvh.points_.Begin() + start + count, ComparePointZ);
+
+		unsigned half = count / 2;
+		BuildBVHNode(bvh, start, half);
+		unsigned right = BuildBVHNode(bvh, start + half, count - half);
+		// The node vector may have grown, do not use the reference from above
+		bvh.nodes_[index].right_ = right;
+		return index;
+	}
+
+	void SpatialSnap::FindNearest(const VertexBVH& bvh, unsigned index, const Vector3& position, Vector3& best, float& bestDistSquared) const
+	{
+		const BVHNode& node = bvh.nodes_[index];
+		if (BoxDistanceSquared(node.box_, position) >= bestDistSquared)
+			return;
+
+		if (node.right_ == 0)
+		{
+			for (unsigned i = node.start_; i < node.start_ + node.count_; ++i)
+			{
+				float distSquared = (bvh.points_[i] - position).LengthSquared();
+				if (distSquared < bestDistSquared)
+				{
+					best = bvh.points_[i];
+					bestDistSquared = distSquared;
+				}
+			}
+			return;
+		}
+
+		// Visit the nearer child first, the farther one is then usually culled
+		unsigned left = index + 1;
+		unsigned right = node.right_;
+		if (BoxDistanceSquared(bvh.nodes_[right].box_, position) < BoxDistanceSquared(bvh.nodes_[left].box_, position))
+			Swap(left, right);
+
+		FindNearest(bvh, left, position, best, bestDistSquared);
+		FindNearest(bvh, right, position, best, bestDistSquared);
+	}
+
+	void SpatialSnap::HandleModelReloaded(StringHash eventType, VariantMap& eventData)
+	{
+		Model* model = static_cast<Model*>(GetEventSender());
+		vertexBVHs_.Erase(model);
+		UnsubscribeFromEvent(model, E_RELOADFINISHED);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Container/HashMap.h"
+#include "../Math/BoundingBox.h"
+#include "../Scene/Node.h"
+
+namespace Urho3D
+{
+	class Octree;
+	class Drawable;
+	class Model;
+
+	/// what a moved node snaps to, besides the grid
+	enum SpatialSnapMode
+	{
+		SPATIAL_SNAP_NONE = 0,
+		/// rest the bounds bottom on the surface below
+		SPATIAL_SNAP_SURFACE,
+		/// move the pivot onto the nearest vertex of another model
+		SPATIAL_SNAP_VERTEX,
+		/// line up the bounds faces with the bounds of nearby objects
+		SPATIAL_SNAP_BOUNDS
+	};
+
+	/// snap queries against the other objects of a scene. Candidates come from the octree, vertices from a bounding volume
+	/// hierarchy that is built once per model and cached.
+	class SpatialSnap : public Object
+	{
+		OBJECT(SpatialSnap);
+	public:
+		/// Construct.
+		SpatialSnap(Context* context);
+		/// Destruct.
+		virtual ~SpatialSnap();
+
+		/// return the snapped world position for node if it were at position. Nodes in excluded and their children are ignored,
+		/// vertex and bounds snapping only reach maxDistance.
+		Vector3 Snap(SpatialSnapMode mode, Octree* octree, Node* node, const Vector3& position, const Vector<Node*>& excluded, float maxDistance);
+		/// world bounds of the node's drawables and those of its children, a point at the node position if there are none
+		BoundingBox GetNodeBounds(Node* node);
+		/// forget the vertex hierarchies, e.g. after models were reloaded
+		void Clear();
+
+	protected:
+		struct BVHNode
+		{
+			BoundingBox box_;
+			/// first point and point count of a leaf
+			unsigned start_;
+			unsigned count_;
+			/// index of the second child, the first one directly follows. 0 for leaves.
+			unsigned right_;
+		};
+
+		struct VertexBVH
+		{
+			/// rebuilt when the model is gone, the pointer may be reused
+			WeakPtr<Model> model_;
+			PODVector<Vector3> points_;
+			PODVector<BVHNode> nodes_;
+		};
+
+		Vector3 SnapToSurface(Octree* octree, const BoundingBox& bounds, const Vector3& position, const Vector<Node*>& excluded);
+		Vector3 SnapToVertex(Octree* octree, const Vector3& position, const Vector<Node*>& excluded, float maxDistance);
+		Vector3 SnapToBounds(Octree* octree, const BoundingBox& bounds, const Vector3& position, const Vector<Node*>& excluded, float maxDistance);
+
+		/// true for drawables that are not part of the scene (editor helpers) or belong to an excluded node
+		bool IsExcluded(Octree* octree, Drawable* drawable, const Vector<Node*>& excluded) const;
+		void MergeNodeBounds(Node* node, BoundingBox& bounds) const;
+		VertexBVH* GetVertexBVH(Model* model);
+		void BuildVertexBVH(VertexBVH& bvh, Model* model);
+		unsigned BuildBVHNode(VertexBVH& bvh, unsigned start, unsigned count);
+		/// nearest point to position closer than sqrt(bestDistSquared), updates best and bestDistSquared
+		void FindNearest(const VertexBVH& bvh, unsigned index, const Vector3& position, Vector3& best, float& bestDistSquared) const;
+		/// drop the hierarchy of a reloaded model
+		void HandleModelReloaded(StringHash eventType, VariantMap& eventData);
+
+		HashMap<Model*, VertexBVH> vertexBVHs_;
+		/// octree query results, reused
+		PODVector<Drawable*> drawables_;
+	};
+}
@@ -1,18 +1,268 @@
 #include "../Urho3D.h"
 #include "InputActionSystem.h"
+#include "../Input/Input.h"
 #include "../Input/InputEvents.h"
+#include "../Core/Timer.h"
+#include "../Core/CoreEvents.h"
+#include "../IO/Log.h"
 #include "../Core/Variant.h"
 #include "SDL/SDL_stdinc.h"
 
 namespace Urho3D
 {
+	/// binding with its input slot, gathered before the bindings are grouped by slot
+	struct SlotBinding
+	{
+		unsigned		slot_;
+		ActionBinding	binding_;
+	};
+
+	/// group the bindings by slot, keeping their order within a slot
+	static void BuildBindingTable(ActionBindingTable& table, unsigned numSlots, const PODVector<SlotBinding>& entries)
+	{
+		table.ranges_.Resize(numSlots + 1);
+		for (unsigned i = 0; i <= numSlots; ++i)
+			table.ranges_[i] = 0;
+		for (unsigned i = 0; i < entries.Size(); ++i)
+			++table.ranges_[entries[i].slot_ + 1];
+		for (unsigned i = 1; i <= numSlots; ++i)
+			table.ranges_[i] += table.ranges_[i - 1];
+
+		PODVector<unsigned> next(table.ranges_.Buffer(), numSlots);
+		table.bindings_.Resize(entries.Size());
+		for (unsigned i = 0; i < entries.Size(); ++i)
+			table.bindings_[next[entries[i].slot_]++] = entries[i].binding_;
+	}
+
+	static void AddSlotBinding(PODVector<SlotBinding>& entries, unsigned slot, unsigned action, sInputAction* input, unsigned mask)
+	{
+		SlotBinding entry;
+		entry.slot_ = slot;
+		entry.binding_.action_ = action;
+		entry.binding_.input_ = input;
+		entry.binding_.mask_ = mask;
+		entry.binding_.deadZone_ = 0.0f;
+		entry.binding_.exponent_ = 1.0f;
+		entry.binding_.scale_ = 1.0f;
+		entries.Push(entry);
+	}
+
+	/// response of an absolute axis position in -1 to 1, the dead zone is cut out and the rest stretched back to the full range
+	static float GetAxisResponse(const ActionBinding& binding, float position)
+	{
+		float magnitude = Abs(position);
+		if (magnitude <= binding.deadZone_)
+			return 0.0f;
+		magnitude = Min((magnitude - binding.deadZone_) / (1.0f - binding.deadZone_), 1.0f);
+		if (binding.exponent_ != 1.0f)
+			magnitude = powf(magnitude, binding.exponent_);
+		return (position < 0.0f ? -magnitude : magnitude) * binding.scale_;
+	}
+
+	/// response of a relative axis delta, deltas within the dead zone are jitter
+	static float GetRelativeAxisResponse(const ActionBinding& binding, float delta)
+	{
+		float magnitude = Abs(delta);
+		if (magnitude <= binding.deadZone_)
+			return 0.0f;
+		magnitude -= binding.deadZone_;
+		if (binding.exponent_ != 1.0f)
+			magnitude = powf(magnitude, binding.exponent_);
+		return (delta < 0.0f ? -magnitude : magnitude) * binding.scale_;
+	}
+
+	/// table slot of a hat direction bit, MAX_ACTION_JOYSTICKHATS * 4 if out of range
+	static unsigned GetHatSlot(unsigned hat, unsigned bit)
+	{
+		return hat < MAX_ACTION_JOYSTICKHATS ? hat * 4 + bit : MAX_ACTION_JOYSTICKHATS * 4;
+	}
+
+	/// table slot of a mouse button, the index of its lowest bit
+	static unsigned GetMouseButtonSlot(unsigned button)
+	{
+		for (unsigned i = 0; i < MAX_ACTION_MOUSEBUTTONS; ++i)
+		{
+			if (button & (1u << i))
+				return i;
+		}
+		return MAX_ACTION_MOUSEBUTTONS;
+	}
+
+	void ActionSnapshot::Reset(unsigned numActions)
+	{
+		pressed_.Clear();
+		held_.Clear();
+		released_.Clear();
+		relative_.Clear();
+		values_.Clear();
+		downCounts_.Clear();
+		Grow(numActions);
+	}
+
+	void ActionSnapshot::BeginFrame(unsigned frameNumber)
+	{
+		frameNumber_ = frameNumber;
+		for (unsigned i = 0; i < pressed_.Size(); ++i)
+		{
+			pressed_[i] = 0;
+			released_[i] = 0;
+
+			// The relative axes start the frame at 0
+			if (relative_[i])
+			{
+				for (unsigned bit = 0; bit < 32; ++bit)
+				{
+					if (relative_[i] & (1u << bit))
+						values_[(i << 5) + bit] = 0.0f;
+				}
+			}
+		}
+	}
+
+	bool ActionSnapshot::SetDown(unsigned action, bool down)
+	{
+		Grow(action + 1);
+		unsigned char& count = downCounts_[action];
+		unsigned word = action >> 5;
+		unsigned bit = 1u << (action & 31);
+		if (down)
+		{
+			if (count++)
+				return false;
+			pressed_[word] |= bit;
+			held_[word] |= bit;
+		}
+		else
+		{
+			if (!count || --count)
+				return false;
+			released_[word] |= bit;
+			held_[word] &= ~bit;
+		}
+		values_[action] = down ? 1.0f : 0.0f;
+		return true;
+	}
+
+	void ActionSnapshot::SetValue(unsigned action, float value)
+	{
+		Grow(action + 1);
+		values_[action] = value;
+	}
+
+	void ActionSnapshot::AddValue(unsigned action, float delta)
+	{
+		Grow(action + 1);
+		unsigned bit = 1u << (action & 31);
+		pressed_[action >> 5] |= bit;
+		relative_[action >> 5] |= bit;
+		values_[action] += delta;
+	}
+
+	void ActionSnapshot::Grow(unsigned numActions)
+	{
+		unsigned numWords = (numActions + 31) >> 5;
+		if (pressed_.Size() < numWords)
+		{
+			unsigned oldSize = pressed_.Size();
+			pressed_.Resize(numWords);
+			held_.Resize(numWords);
+			released_.Resize(numWords);
+			relative_.Resize(numWords);
+			for (unsigned i = oldSize; i < numWords; ++i)
+			{
+				pressed_[i] = 0;
+				held_[i] = 0;
+				released_[i] = 0;
+				relative_[i] = 0;
+			}
+		}
+		if (values_.Size() < numActions)
+		{
+			unsigned oldSize = values_.Size();
+			values_.Resize(numActions);
+			downCounts_.Resize(numActions);
+			for (unsigned i = oldSize; i < numActions; ++i)
+			{
+				values_[i] = 0.0f;
+				downCounts_[i] = 0;
+			}
+		}
+	}
+
+	enum InputRecordValue
+	{
+		RECORD_INT = 0,
+		RECORD_FLOAT,
+		RECORD_BOOL
+	};
+
+	/// recorded input event: its type and the parameters the handlers read, stored in this order
+	struct InputRecordFormat
+	{
+		StringHash			eventType_;
+		unsigned			numParams_;
+		StringHash			params_[3];
+		InputRecordValue	values_[3];
+	};
+
+	/// the record type is the index in this table, HandleReplayFrame has the handlers in the same order
+	static const InputRecordFormat INPUT_RECORD_FORMATS[] =
+	{
+		{ E_KEYDOWN, 2, { KeyDown::P_SCANCODE, KeyDown::P_REPEAT }, { RECORD_INT, RECORD_BOOL } },
+		{ E_KEYUP, 1, { KeyUp::P_SCANCODE }, { RECORD_INT } },
+		{ E_MOUSEBUTTONDOWN, 1, { MouseButtonDown::P_BUTTON }, { RECORD_INT } },
+		{ E_MOUSEBUTTONUP, 1, { MouseButtonUp::P_BUTTON }, { RECORD_INT } },
+		{ E_MOUSEMOVE, 2, { MouseMove::P_DX, MouseMove::P_DY }, { RECORD_INT, RECORD_INT } },
+		{ E_MOUSEWHEEL, 1, { MouseWheel::P_WHEEL }, { RECORD_INT } },
+		{ E_JOYSTICKBUTTONDOWN, 1, { JoystickButtonDown::P_BUTTON }, { RECORD_INT } },
+		{ E_JOYSTICKBUTTONUP, 1, { JoystickButtonUp::P_BUTTON }, { RECORD_INT } },
+		{ E_JOYSTICKAXISMOVE, 2, { JoystickAxisMove::P_AXIS, JoystickAxisMove::P_POSITION }, { RECORD_INT, RECORD_FLOAT } },
+		{ E_JOYSTICKHATMOVE, 2, { JoystickHatMove::P_HAT, JoystickHatMove::P_POSITION }, { RECORD_INT, RECORD_INT } },
+		{ E_TOUCHBEGIN, 3, { TouchBegin::P_TOUCHID, TouchBegin::P_X, TouchBegin::P_Y }, { RECORD_INT, RECORD_INT, RECORD_INT } },
+		{ E_TOUCHMOVE, 3, { TouchMove::P_TOUCHID, TouchMove::P_X, TouchMove::P_Y }, { RECORD_INT, RECORD_INT, RECORD_INT } },
+		{ E_TOUCHEND, 1, { TouchEnd::P_TOUCHID }, { RECORD_INT } }
+	};
+	static const unsigned NUM_INPUT_RECORD_FORMATS = sizeof(INPUT_RECORD_FORMATS) / sizeof(INPUT_RECORD_FORMATS[0]);
+	/// record type of an action transition: action id, down and value. Replays skip them, the actions follow from the input.
+	static const unsigned INPUT_RECORD_ACTION = NUM_INPUT_RECORD_FORMATS;
+
+	/// signed values are zigzag encoded, so small negative deltas stay small
+	static unsigned EncodeRecordInt(int value)
+	{
+		return ((unsigned)value << 1) ^ (unsigned)(value >> 31);
+	}
+
+	static int DecodeRecordInt(unsigned value)
+	{
+		return (int)(value >> 1) ^ -(int)(value & 1);
+	}
+
 	InputActionSystem::InputActionSystem(Context* context) : Object(context),
-		currentState_(NULL)
+		sendEvents_(true),
+		currentState_(NULL),
+		isRecording_(false),
+		recordFrame_(0),
+		isReplaying_(false),
+		injecting_(false),
+		replayFrame_(0),
+		nextReplayFrame_(M_MAX_UNSIGNED)
 	{
 		SubscribeToEvent(E_KEYDOWN, HANDLER(InputActionSystem, HandleKeyDown));
 		SubscribeToEvent(E_KEYUP, HANDLER(InputActionSystem, HandleKeyUp));
 		SubscribeToEvent(E_MOUSEBUTTONDOWN, HANDLER(InputActionSystem, HandleMouseButtonDown));
 		SubscribeToEvent(E_MOUSEBUTTONUP, HANDLER(InputActionSystem, HandleMouseButtonUp));
+		SubscribeToEvent(E_MOUSEMOVE, HANDLER(InputActionSystem, HandleMouseMove));
+		SubscribeToEvent(E_MOUSEWHEEL, HANDLER(InputActionSystem, HandleMouseWheel));
+		SubscribeToEvent(E_JOYSTICKBUTTONDOWN, HANDLER(InputActionSystem, HandleJoystickButtonDown));
+		SubscribeToEvent(E_JOYSTICKBUTTONUP, HANDLER(InputActionSystem, HandleJoystickButtonUp));
+		SubscribeToEvent(E_JOYSTICKAXISMOVE, HANDLER(InputActionSystem, HandleJoystickAxisMove));
+		SubscribeToEvent(E_JOYSTICKHATMOVE, HANDLER(InputActionSystem, HandleJoystickHatMove));
+		SubscribeToEvent(E_TOUCHBEGIN, HANDLER(InputActionSystem, HandleTouchBegin));
+		SubscribeToEvent(E_TOUCHMOVE, HANDLER(InputActionSystem, HandleTouchMove));
+		SubscribeToEvent(E_TOUCHEND, HANDLER(InputActionSystem, HandleTouchEnd));
+
+		for (unsigned i = 0; i < MAX_ACTION_JOYSTICKHATS; ++i)
+			hatPositions_[i] = HAT_CENTER;
 	}
 
 	InputActionSystem::~InputActionSystem()
@@ -54,7 +304,7 @@ namespace Urho3D
 			if (stack_.Empty() || stack_.Back() != it->second_)
 			{
 				stack_.Push(it->second_);
-				currentState_ = it->second_;
+				SetCurrentState(it->second_);
 			}
 	}
 
@@ -65,12 +315,7 @@ namespace Urho3D
 
 		ActionState* last = stack_.Back();
 		stack_.Pop();
-		if (stack_.Empty())
-		{
-			currentState_ = NULL;
-		}
-		else
-			currentState_ = stack_.Back();
+		SetCurrentState(stack_.Empty() ? NULL : stack_.Back());
 
 		return last;
 	}
@@ -80,243 +325,527 @@ namespace Urho3D
 		return currentState_;
 	}
 
-	void InputActionSystem::HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
+	const ActionSnapshot& InputActionSystem::GetSnapshot()
 	{
-		using namespace MouseButtonDown;
-
-		int mousebutton = eventData[P_BUTTON].GetInt();
-		unsigned mouseButtonDown = eventData[P_BUTTONS].GetUInt();
-
-		if (currentState_)
-		{
-			HashMap<unsigned, HashSet<StringHash> >::Iterator it = currentState_->mouseButtonMapping_.Find(mouseButtonDown);
+		// Input events are handled while the frame begins, so the transitions recorded in this frame are kept
+		unsigned frameNumber = GetSubsystem<Time>()->GetFrameNumber();
+		if (snapshot_.GetFrameNumber() != frameNumber)
+			snapshot_.BeginFrame(frameNumber);
+		return snapshot_;
+	}
 
-			if (it != currentState_->mouseButtonMapping_.End())
-			{
-				HashSet<StringHash>::Iterator it2;
-				for (it2 = it->second_.Begin(); it2 != it->second_.End(); it2++)
-				{
-					using namespace InputAction;
+	void InputActionSystem::SetCurrentState(ActionState* state)
+	{
+		if (state == currentState_)
+			return;
 
-					VariantMap& neweventData = GetEventDataMap();
-					neweventData[P_ACTIONID] = (*it2);
-					neweventData[P_ISDOWN] = true;
+		currentState_ = state;
+		snapshot_.Reset(state ? state->GetNumActions() : 0);
+		axisValues_.Clear();
+	}
 
-					SendEvent(E_INPUTACTION, neweventData);
-				}
-			}
+	void InputActionSystem::HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace MouseButtonDown;
 
-			HashMap<unsigned, HashSet<sInputAction* > >::Iterator it1 = currentState_->mouseButtonMapping2_.Find(mousebutton);
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
 
-			if (it1 != currentState_->mouseButtonMapping2_.End())
-			{
-				HashSet<sInputAction* >::Iterator it3;
-				for (it3 = it1->second_.Begin(); it3 != it1->second_.End(); it3++)
-				{
-					(*it3)->downMask_ |= MouseButton_Mask;
-					if ((*it3)->IsActive())
-					{
-						using namespace InputAction;
-						VariantMap& neweventData = GetEventDataMap();
-						neweventData[P_ACTIONID] = (*it3)->id_;
-						neweventData[P_ISDOWN] = true;
-
-						SendEvent(E_INPUTACTION, neweventData);
-					}
-				}
-			}
+		unsigned slot = GetMouseButtonSlot(eventData[P_BUTTON].GetUInt());
+		if (slot < MAX_ACTION_MOUSEBUTTONS)
+		{
+			const ActionBindingTable& table = currentState_->GetMouseButtonTable();
+			DispatchBindings(table.Begin(slot), table.End(slot), true);
 		}
 	}
 
 	void InputActionSystem::HandleMouseButtonUp(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace MouseButtonUp;
-		int mousebutton = eventData[P_BUTTON].GetInt();
-		unsigned mouseButtonDown = eventData[P_BUTTONS].GetUInt();
-
-		if (currentState_)
-		{
-			HashMap<unsigned, HashSet<StringHash> >::Iterator it = currentState_->mouseButtonMapping_.Find(mousebutton);
-
-			if (it != currentState_->mouseButtonMapping_.End())
-			{
-				HashSet<StringHash>::Iterator it2;
-				for (it2 = it->second_.Begin(); it2 != it->second_.End(); it2++)
-				{
-					using namespace InputAction;
-
-					VariantMap& neweventData = GetEventDataMap();
-					neweventData[P_ACTIONID] = (*it2);
-					neweventData[P_ISDOWN] = false;
-
-					SendEvent(E_INPUTACTION, neweventData);
-				}
-			}
 
-			HashMap<unsigned, HashSet< sInputAction* > >::Iterator it1 = currentState_->mouseButtonMapping2_.Find(mousebutton);
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
 
-			if (it1 != currentState_->mouseButtonMapping2_.End())
-			{
-				HashSet< sInputAction* >::Iterator it3;
-				for (it3 = it1->second_.Begin(); it3 != it1->second_.End(); it3++)
-				{
-					(*it3)->downMask_ &= ~MouseButton_Mask;
-					if (!(*it3)->IsActive())
-					{
-						using namespace InputAction;
-						VariantMap& neweventData = GetEventDataMap();
-						neweventData[P_ACTIONID] = (*it3)->id_;
-						neweventData[P_ISDOWN] = false;
-
-						SendEvent(E_INPUTACTION, neweventData);
-					}
-				}
-			}
+		unsigned slot = GetMouseButtonSlot(eventData[P_BUTTON].GetUInt());
+		if (slot < MAX_ACTION_MOUSEBUTTONS)
+		{
+			const ActionBindingTable& table = currentState_->GetMouseButtonTable();
+			DispatchBindings(table.Begin(slot), table.End(slot), false);
 		}
 	}
 
 	void InputActionSystem::HandleMouseMove(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace MouseMove;
+
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
+
+		int dx = eventData[P_DX].GetInt();
+		int dy = eventData[P_DY].GetInt();
+		if (dx)
+			DispatchRelativeAxis(ACTION_AXIS_MOUSEX, (float)dx);
+		if (dy)
+			DispatchRelativeAxis(ACTION_AXIS_MOUSEY, (float)dy);
 	}
 
 	void InputActionSystem::HandleMouseWheel(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace MouseWheel;
+
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
+
+		int wheel = eventData[P_WHEEL].GetInt();
+		if (wheel)
+			DispatchRelativeAxis(ACTION_AXIS_WHEEL, (float)wheel);
 	}
 
 	void InputActionSystem::HandleKeyDown(StringHash eventType, VariantMap& eventData)
 	{
 		using namespace KeyDown;
-		int key = eventData[P_KEY].GetInt();
-		bool repeat = eventData[P_REPEAT].GetBool();
 
-		if (currentState_ && !repeat)
+		if (!AcceptInput(eventType, eventData) || !currentState_ || eventData[P_REPEAT].GetBool())
+			return;
+
+		unsigned scancode = eventData[P_SCANCODE].GetUInt();
+		if (scancode < MAX_ACTION_SCANCODES)
 		{
-			HashMap<int, HashSet<StringHash> >::Iterator it = currentState_->keyActionMapping_.Find(key);
+			const ActionBindingTable& table = currentState_->GetKeyTable();
+			DispatchBindings(table.Begin(scancode), table.End(scancode), true);
+		}
+	}
 
-			if (it != currentState_->keyActionMapping_.End())
-			{
-				HashSet<StringHash>::Iterator it2;
-				for (it2 = it->second_.Begin(); it2 != it->second_.End(); it2++)
-				{
-					using namespace InputAction;
+	void InputActionSystem::HandleKeyUp(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace KeyUp;
 
-					VariantMap& neweventData = GetEventDataMap();
-					neweventData[P_ACTIONID] = (*it2);
-					neweventData[P_ISDOWN] = true;
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
 
-					SendEvent(E_INPUTACTION, neweventData);
-				}
-			}
+		unsigned scancode = eventData[P_SCANCODE].GetUInt();
+		if (scancode < MAX_ACTION_SCANCODES)
+		{
+			const ActionBindingTable& table = currentState_->GetKeyTable();
+			DispatchBindings(table.Begin(scancode), table.End(scancode), false);
+		}
+	}
+
+	void InputActionSystem::HandleJoystickButtonDown(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace JoystickButtonDown;
+
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
+
+		unsigned button = eventData[P_BUTTON].GetUInt();
+		if (button < MAX_ACTION_JOYSTICKBUTTONS)
+		{
+			const ActionBindingTable& table = currentState_->GetJoystickButtonTable();
+			DispatchBindings(table.Begin(button), table.End(button), true);
+		}
+	}
+
+	void InputActionSystem::HandleJoystickButtonUp(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace JoystickButtonUp;
+
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
+
+		unsigned button = eventData[P_BUTTON].GetUInt();
+		if (button < MAX_ACTION_JOYSTICKBUTTONS)
+		{
+			const ActionBindingTable& table = currentState_->GetJoystickButtonTable();
+			DispatchBindings(table.Begin(button), table.End(button), false);
+		}
+	}
+
+	void InputActionSystem::HandleJoystickAxisMove(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace JoystickAxisMove;
+
+		if (!AcceptInput(eventType, eventData) || !currentState_)
+			return;
+
+		unsigned axis = eventData[P_AXIS].GetUInt();
+		if (axis < MAX_ACTION_JOYSTICKAXES)
+			DispatchAxis(axis, eventData[P_POSITION].GetFloat());
+	}
+
+	void InputActionSystem::HandleJoystickHatMove(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace JoystickHatMove;
+
+		if (!AcceptInput(eventType, eventData))
+			return;
 
-			HashMap<int, HashSet< sInputAction* > >::Iterator it1 = currentState_->keyActionMapping2_.Find(key);
+		unsigned hat = eventData[P_HAT].GetUInt();
+		if (hat >= MAX_ACTION_JOYSTICKHATS)
+			return;
 
-			if (it1 != currentState_->keyActionMapping2_.End())
+		int position = eventData[P_POSITION].GetInt();
+		int changed = position ^ hatPositions_[hat];
+		hatPositions_[hat] = position;
+		if (!currentState_)
+			return;
+
+		// Diagonals move two direction bits at once
+		const ActionBindingTable& table = currentState_->GetJoystickHatTable();
+		for (unsigned bit = 0; bit < 4; ++bit)
+		{
+			if (changed & (1 << bit))
 			{
-				HashSet< sInputAction* >::Iterator it3;
-				for (it3 = it1->second_.Begin(); it3 != it1->second_.End(); it3++)
-				{
-					(*it3)->downMask_ |= Key_Mask;
-					if ((*it3)->IsActive())
-					{
-						using namespace InputAction;
+				unsigned slot = GetHatSlot(hat, bit);
+				DispatchBindings(table.Begin(slot), table.End(slot), (position & (1 << bit)) != 0);
+			}
+		}
+	}
 
-						VariantMap& neweventData = GetEventDataMap();
-						neweventData[P_ACTIONID] = (*it3)->id_;
-						neweventData[P_ISDOWN] = true;
+	void InputActionSystem::HandleTouchEnd(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace TouchEnd;
 
-						SendEvent(E_INPUTACTION, neweventData);
-					}
-				}
+		if (!AcceptInput(eventType, eventData))
+			return;
+
+		int id = eventData[P_TOUCHID].GetInt();
+		for (unsigned i = 0; i < touches_.Size(); ++i)
+		{
+			if (touches_[i].id_ == id)
+			{
+				touches_.Erase(i);
+				DispatchTouchCount(touches_.Size() + 1, touches_.Size());
+				return;
 			}
 		}
 	}
 
-	void InputActionSystem::HandleKeyUp(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::HandleTouchBegin(StringHash eventType, VariantMap& eventData)
 	{
-		using namespace KeyUp;
-		int key = eventData[P_KEY].GetInt();
+		using namespace TouchBegin;
 
-		if (currentState_)
+		if (!AcceptInput(eventType, eventData))
+			return;
+
+		TouchPoint touch;
+		touch.id_ = eventData[P_TOUCHID].GetInt();
+		touch.position_ = IntVector2(eventData[P_X].GetInt(), eventData[P_Y].GetInt());
+		touches_.Push(touch);
+		DispatchTouchCount(touches_.Size() - 1, touches_.Size());
+	}
+
+	void InputActionSystem::HandleTouchMove(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace TouchMove;
+
+		if (!AcceptInput(eventType, eventData))
+			return;
+
+		int id = eventData[P_TOUCHID].GetInt();
+		unsigned index = 0;
+		while (index < touches_.Size() && touches_[index].id_ != id)
+			++index;
+		if (index == touches_.Size())
+			return;
+
+		IntVector2 position(eventData[P_X].GetInt(), eventData[P_Y].GetInt());
+		IntVector2 oldPosition = touches_[index].position_;
+		touches_[index].position_ = position;
+		if (!currentState_)
+			return;
+
+		if (touches_.Size() == 1)
 		{
-			HashMap<int, HashSet<StringHash> >::Iterator it = currentState_->keyActionMapping_.Find(key);
+			if (position.x_ != oldPosition.x_)
+				DispatchRelativeAxis(ACTION_AXIS_TOUCHX, (float)(position.x_ - oldPosition.x_));
+			if (position.y_ != oldPosition.y_)
+				DispatchRelativeAxis(ACTION_AXIS_TOUCHY, (float)(position.y_ - oldPosition.y_));
+		}
+		else if (touches_.Size() == 2)
+		{
+			IntVector2 other = touches_[1 - index].position_;
+			float oldDistance = Vector2((float)(oldPosition.x_ - other.x_), (float)(oldPosition.y_ - other.y_)).Length();
+			float distance = Vector2((float)(position.x_ - other.x_), (float)(position.y_ - other.y_)).Length();
+			if (distance != oldDistance)
+				DispatchRelativeAxis(ACTION_AXIS_PINCH, distance - oldDistance);
+		}
+	}
 
-			if (it != currentState_->keyActionMapping_.End())
+	void InputActionSystem::DispatchBindings(const ActionBinding* begin, const ActionBinding* end, bool down)
+	{
+		for (const ActionBinding* binding = begin; binding != end; ++binding)
+		{
+			sInputAction* input = binding->input_;
+			if (input)
 			{
-				HashSet<StringHash>::Iterator it2;
-				for (it2 = it->second_.Begin(); it2 != it->second_.End(); it2++)
-				{
-					using namespace InputAction;
+				// Combined inputs are sent when they become active and when they stop being active
+				bool wasActive = input->IsActive();
+				if (down)
+					input->downMask_ |= binding->mask_;
+				else
+					input->downMask_ &= ~binding->mask_;
+				if (input->IsActive() == wasActive)
+					continue;
+			}
 
-					VariantMap& neweventData = GetEventDataMap();
-					neweventData[P_ACTIONID] = (*it2);
-					neweventData[P_ISDOWN] = false;
+			SetActionDown(binding->action_, down);
+		}
+	}
 
-					SendEvent(E_INPUTACTION, neweventData);
-				}
-			}
+	void InputActionSystem::DispatchAxis(unsigned axis, float position)
+	{
+		const ActionBindingTable& table = currentState_->GetAxisTable();
+		const ActionBinding* end = table.End(axis);
+		GetSnapshot();
+		if (axisValues_.Size() < table.bindings_.Size())
+		{
+			unsigned oldSize = axisValues_.Size();
+			axisValues_.Resize(table.bindings_.Size());
+			for (unsigned i = oldSize; i < axisValues_.Size(); ++i)
+				axisValues_[i] = 0.0f;
+		}
 
-			HashMap<int, HashSet< sInputAction* > >::Iterator it1 = currentState_->keyActionMapping2_.Find(key);
+		for (const ActionBinding* binding = table.Begin(axis); binding != end; ++binding)
+		{
+			float value = GetAxisResponse(*binding, position);
+			float& oldValue = axisValues_[binding - table.bindings_.Buffer()];
+			if (value == oldValue)
+				continue;
+
+			// Leaving or entering the dead zone presses or releases the binding, like a key of the action
+			bool down = value != 0.0f;
+			bool changed = down != (oldValue != 0.0f) && snapshot_.SetDown(binding->action_, down);
+			oldValue = value;
+			if (down)
+				snapshot_.SetValue(binding->action_, value);
+			if (down || changed)
+				NotifyAction(currentState_->actions_[binding->action_], down, value);
+		}
+	}
 
-			if (it1 != currentState_->keyActionMapping2_.End())
-			{
-				HashSet< sInputAction* >::Iterator it3;
-				for (it3 = it1->second_.Begin(); it3 != it1->second_.End(); it3++)
-				{
-					(*it3)->downMask_ &= ~Key_Mask;
+	void InputActionSystem::DispatchRelativeAxis(unsigned axis, float delta)
+	{
+		const ActionBindingTable& table = currentState_->GetAxisTable();
+		const ActionBinding* end = table.End(axis);
+		GetSnapshot();
+		for (const ActionBinding* binding = table.Begin(axis); binding != end; ++binding)
+		{
+			float value = GetRelativeAxisResponse(*binding, delta);
+			if (value == 0.0f)
+				continue;
+
+			snapshot_.AddValue(binding->action_, value);
+			NotifyAction(currentState_->actions_[binding->action_], true, value);
+		}
+	}
 
-					if (!(*it3)->IsActive())
-					{
-						using namespace InputAction;
+	void InputActionSystem::DispatchTouchCount(unsigned oldCount, unsigned newCount)
+	{
+		if (!currentState_)
+			return;
+
+		const ActionBindingTable& table = currentState_->GetTouchTable();
+		if (oldCount > 0 && oldCount < MAX_ACTION_TOUCHES)
+			DispatchBindings(table.Begin(oldCount), table.End(oldCount), false);
+		if (newCount > 0 && newCount < MAX_ACTION_TOUCHES)
+			DispatchBindings(table.Begin(newCount), table.End(newCount), true);
+	}
 
-						VariantMap& neweventData = GetEventDataMap();
-						neweventData[P_ACTIONID] = (*it3)->id_;
-						neweventData[P_ISDOWN] = false;
+	void InputActionSystem::SetActionDown(unsigned action, bool down)
+	{
+		GetSnapshot();
+		if (snapshot_.SetDown(action, down))
+			NotifyAction(currentState_->actions_[action], down, down ? 1.0f : 0.0f);
+	}
 
-						SendEvent(E_INPUTACTION, neweventData);
-					}
-				}
-			}
+	void InputActionSystem::NotifyAction(StringHash actionId, bool down, float value)
+	{
+		using namespace InputAction;
+
+		if (isRecording_)
+		{
+			WriteRecordHeader(INPUT_RECORD_ACTION);
+			recording_.WriteStringHash(actionId);
+			recording_.WriteBool(down);
+			recording_.WriteFloat(value);
 		}
+		if (!sendEvents_)
+			return;
+
+		VariantMap& eventData = GetEventDataMap();
+		eventData[P_ACTIONID] = actionId;
+		eventData[P_ISDOWN] = down;
+		eventData[P_VALUE] = value;
+		SendEvent(E_INPUTACTION, eventData);
 	}
 
-	void InputActionSystem::HandleJoystickButtonDown(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::StartRecording()
 	{
-		using namespace JoystickButtonDown;
+		recording_.Clear();
+		isRecording_ = true;
+		recordFrame_ = GetSubsystem<Time>()->GetFrameNumber() + 1;
 	}
 
-	void InputActionSystem::HandleJoystickButtonUp(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::StopRecording()
 	{
-		using namespace JoystickButtonUp;
+		isRecording_ = false;
 	}
 
-	void InputActionSystem::HandleJoystickAxisMove(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::StartReplay(const PODVector<unsigned char>& recording)
 	{
-		using namespace JoystickAxisMove;
+		replay_.SetData(recording);
+		isReplaying_ = true;
+		replayFrame_ = GetSubsystem<Time>()->GetFrameNumber() + 1;
+		nextReplayFrame_ = M_MAX_UNSIGNED;
+		ResetInputState();
+		SubscribeToEvent(E_BEGINFRAME, HANDLER(InputActionSystem, HandleReplayFrame));
 	}
 
-	void InputActionSystem::HandleJoystickHatMove(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::StopReplay()
 	{
-		using namespace JoystickHatMove;
+		if (!isReplaying_)
+			return;
+
+		isReplaying_ = false;
+		replay_.Clear();
+		UnsubscribeFromEvent(E_BEGINFRAME);
+		// Inputs the replay left held would never see their release
+		ResetInputState();
 	}
 
-	void InputActionSystem::HandleTouchEnd(StringHash eventType, VariantMap& eventData)
+	bool InputActionSystem::AcceptInput(StringHash eventType, VariantMap& eventData)
 	{
-		using namespace TouchEnd;
+		// Live input is ignored while a replay drives the actions
+		if (isReplaying_ && !injecting_)
+			return false;
+		if (!isRecording_)
+			return true;
+
+		for (unsigned i = 0; i < NUM_INPUT_RECORD_FORMATS; ++i)
+		{
+			const InputRecordFormat& format = INPUT_RECORD_FORMATS[i];
+			if (format.eventType_ != eventType)
+				continue;
+
+			WriteRecordHeader(i);
+			for (unsigned j = 0; j < format.numParams_; ++j)
+			{
+				const Variant& value = eventData[format.params_[j]];
+				if (format.values_[j] == RECORD_FLOAT)
+					recording_.WriteFloat(value.GetFloat());
+				else if (format.values_[j] == RECORD_BOOL)
+					recording_.WriteBool(value.GetBool());
+				else
+					recording_.WriteVLE(EncodeRecordInt(value.GetInt()));
+			}
+			break;
+		}
+		return true;
 	}
 
-	void InputActionSystem::HandleTouchBegin(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::WriteRecordHeader(unsigned type)
 	{
-		using namespace TouchBegin;
+		unsigned frame = GetSubsystem<Time>()->GetFrameNumber();
+		recording_.WriteVLE(frame > recordFrame_ ? frame - recordFrame_ : 0);
+		recordFrame_ = Max(frame, recordFrame_);
+		recording_.WriteUByte((unsigned char)type);
 	}
 
-	void InputActionSystem::HandleTouchMove(StringHash eventType, VariantMap& eventData)
+	void InputActionSystem::ResetInputState()
 	{
-		using namespace TouchMove;
+		snapshot_.Reset(currentState_ ? currentState_->GetNumActions() : 0);
+		axisValues_.Clear();
+		touches_.Clear();
+		for (unsigned i = 0; i < MAX_ACTION_JOYSTICKHATS; ++i)
+			hatPositions_[i] = HAT_CENTER;
+
+		if (currentState_)
+		{
+			const ActionBindingTable* tables[] = { &currentState_->GetKeyTable(), &currentState_->GetMouseButtonTable() };
+			for (unsigned i = 0; i < 2; ++i)
+			{
+				for (unsigned j = 0; j < tables[i]->bindings_.Size(); ++j)
+				{
+					if (tables[i]->bindings_[j].input_)
+						tables[i]->bindings_[j].input_->downMask_ = 0;
+				}
+			}
+		}
+	}
+
+	void InputActionSystem::HandleReplayFrame(StringHash eventType, VariantMap& eventData)
+	{
+		typedef void (InputActionSystem::*InputHandler)(StringHash, VariantMap&);
+		static const InputHandler handlers[] =
+		{
+			&InputActionSystem::HandleKeyDown,
+			&InputActionSystem::HandleKeyUp,
+			&InputActionSystem::HandleMouseButtonDown,
+			&InputActionSystem::HandleMouseButtonUp,
+			&InputActionSystem::HandleMouseMove,
+			&InputActionSystem::HandleMouseWheel,
+			&InputActionSystem::HandleJoystickButtonDown,
+			&InputActionSystem::HandleJoystickButtonUp,
+			&InputActionSystem::HandleJoystickAxisMove,
+			&InputActionSystem::HandleJoystickHatMove,
+			&InputActionSystem::HandleTouchBegin,
+			&InputActionSystem::HandleTouchMove,
+			&InputActionSystem::HandleTouchEnd
+		};
+
+		unsigned frame = GetSubsystem<Time>()->GetFrameNumber();
+		bool corrupt = false;
+		injecting_ = true;
+		while (!replay_.IsEof())
+		{
+			if (nextReplayFrame_ == M_MAX_UNSIGNED)
+				nextReplayFrame_ = replayFrame_ + replay_.ReadVLE();
+			if (nextReplayFrame_ > frame)
+				break;
+
+			replayFrame_ = nextReplayFrame_;
+			nextReplayFrame_ = M_MAX_UNSIGNED;
+			unsigned type = replay_.ReadUByte();
+			if (type == INPUT_RECORD_ACTION)
+			{
+				replay_.ReadStringHash();
+				replay_.ReadBool();
+				replay_.ReadFloat();
+				continue;
+			}
+			if (type >= NUM_INPUT_RECORD_FORMATS)
+			{
+				corrupt = true;
+				break;
+			}
+
+			const InputRecordFormat& format = INPUT_RECORD_FORMATS[type];
+			VariantMap& recordData = GetEventDataMap();
+			for (unsigned j = 0; j < format.numParams_; ++j)
+			{
+				if (format.values_[j] == RECORD_FLOAT)
+					recordData[format.params_[j]] = replay_.ReadFloat();
+				else if (format.values_[j] == RECORD_BOOL)
+					recordData[format.params_[j]] = replay_.ReadBool();
+				else
+					recordData[format.params_[j]] = DecodeRecordInt(replay_.ReadVLE());
+			}
+			(this->*handlers[type])(format.eventType_, recordData);
+		}
+		injecting_ = false;
+
+		if (corrupt || (replay_.IsEof() && nextReplayFrame_ == M_MAX_UNSIGNED))
+		{
+			if (corrupt)
+				LOGERROR("Input recording is corrupt, replay stopped");
+			StopReplay();
+			SendEvent(E_INPUTREPLAYFINISHED);
+		}
 	}
 
-	ActionState::ActionState(Context* context) : Object(context)
+	ActionState::ActionState(Context* context) : Object(context),
+		tablesDirty_(true)
 	{
 	}
 
@@ -330,6 +859,7 @@ namespace Urho3D
 		StringHash actionHash(action);
 		actionNameMapping_[actionHash] = action;
 		keyActionMapping_[key_].Insert(actionHash);
+		tablesDirty_ = true;
 	}
 
 	void ActionState::AddMouseButtonAction(const String& action, unsigned mouseButton)
@@ -337,6 +867,7 @@ namespace Urho3D
 		StringHash actionHash(action);
 		actionNameMapping_[actionHash] = action;
 		mouseButtonMapping_[mouseButton].Insert(actionHash);
+		tablesDirty_ = true;
 	}
 
 	const String& ActionState::GetActionName(const StringHash& actionId)
@@ -370,9 +901,191 @@ namespace Urho3D
 				mouseButtonMapping2_[inAction->mouseButtons_].Insert(inAction);
 				//AddMouseButtonAction(inAction->name_, inAction->mouseButtons_);
 			}
+			tablesDirty_ = true;
+		}
+	}
+
+	unsigned ActionState::GetNumActions()
+	{
+		CompileTables();
+		return actions_.Size();
+	}
+
+	unsigned ActionState::GetActionIndex(StringHash actionId)
+	{
+		CompileTables();
+		HashMap<StringHash, unsigned>::ConstIterator i = actionIndices_.Find(actionId);
+		return i != actionIndices_.End() ? i->second_ : M_MAX_UNSIGNED;
+	}
+
+	StringHash ActionState::GetActionID(unsigned index)
+	{
+		CompileTables();
+		return index < actions_.Size() ? actions_[index] : StringHash::ZERO;
+	}
+
+	const ActionBindingTable& ActionState::GetKeyTable()
+	{
+		CompileTables();
+		return keyTable_;
+	}
+
+	const ActionBindingTable& ActionState::GetMouseButtonTable()
+	{
+		CompileTables();
+		return mouseButtonTable_;
+	}
+
+	const ActionBindingTable& ActionState::GetJoystickButtonTable()
+	{
+		CompileTables();
+		return joystickButtonTable_;
+	}
+
+	const ActionBindingTable& ActionState::GetJoystickHatTable()
+	{
+		CompileTables();
+		return joystickHatTable_;
+	}
+
+	const ActionBindingTable& ActionState::GetAxisTable()
+	{
+		CompileTables();
+		return axisTable_;
+	}
+
+	const ActionBindingTable& ActionState::GetTouchTable()
+	{
+		CompileTables();
+		return touchTable_;
+	}
+
+	unsigned ActionState::AddAction(StringHash id)
+	{
+		HashMap<StringHash, unsigned>::ConstIterator i = actionIndices_.Find(id);
+		if (i != actionIndices_.End())
+			return i->second_;
+
+		actionIndices_[id] = actions_.Size();
+		actions_.Push(id);
+		return actions_.Size() - 1;
+	}
+
+	void ActionState::CompileTables()
+	{
+		if (!tablesDirty_)
+			return;
+		tablesDirty_ = false;
+
+		// Bindings are keyed by scancode, so the keys are looked up in the current keyboard layout. The stored keys are
+		// uppercase like the Urho3D key codes, SDL key codes of letters are lowercase.
+		Input* input = GetSubsystem<Input>();
+		PODVector<SlotBinding> keys;
+		PODVector<SlotBinding> mouseButtons;
+
+		// The plain actions go first in every slot, as they were sent first before
+		for (HashMap<int, HashSet<StringHash> >::ConstIterator i = keyActionMapping_.Begin(); i != keyActionMapping_.End(); ++i)
+		{
+			unsigned scancode = input->GetScancodeFromKey(SDL_tolower(i->first_));
+			if (scancode >= MAX_ACTION_SCANCODES)
+				continue;
+			for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+				AddSlotBinding(keys, scancode, AddAction(*j), NULL, 0);
+		}
+		for (HashMap<unsigned, HashSet<StringHash> >::ConstIterator i = mouseButtonMapping_.Begin(); i != mouseButtonMapping_.End(); ++i)
+		{
+			for (unsigned slot = 0; slot < MAX_ACTION_MOUSEBUTTONS; ++slot)
+			{
+				if (!(i->first_ & (1u << slot)))
+					continue;
+				for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+					AddSlotBinding(mouseButtons, slot, AddAction(*j), NULL, 0);
+			}
+		}
+
+		for (HashMap<int, HashSet<sInputAction*> >::ConstIterator i = keyActionMapping2_.Begin(); i != keyActionMapping2_.End(); ++i)
+		{
+			unsigned scancode = input->GetScancodeFromKey(SDL_tolower(i->first_));
+			if (scancode >= MAX_ACTION_SCANCODES)
+				continue;
+			for (HashSet<sInputAction*>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+				AddSlotBinding(keys, scancode, AddAction((*j)->id_), *j, Key_Mask);
+		}
+		for (HashMap<unsigned, HashSet<sInputAction*> >::ConstIterator i = mouseButtonMapping2_.Begin(); i != mouseButtonMapping2_.End(); ++i)
+		{
+			for (unsigned slot = 0; slot < MAX_ACTION_MOUSEBUTTONS; ++slot)
+			{
+				if (!(i->first_ & (1u << slot)))
+					continue;
+				for (HashSet<sInputAction*>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+					AddSlotBinding(mouseButtons, slot, AddAction((*j)->id_), *j, MouseButton_Mask);
+			}
+		}
+
+		BuildBindingTable(keyTable_, MAX_ACTION_SCANCODES, keys);
+		BuildBindingTable(mouseButtonTable_, MAX_ACTION_MOUSEBUTTONS, mouseButtons);
+
+		const PODVector<ActionMapping>* mappings[] = { &joystickButtonMapping_, &joystickHatMapping_, &axisMapping_, &touchMapping_ };
+		ActionBindingTable* tables[] = { &joystickButtonTable_, &joystickHatTable_, &axisTable_, &touchTable_ };
+		unsigned numSlots[] = { MAX_ACTION_JOYSTICKBUTTONS, MAX_ACTION_JOYSTICKHATS * 4, MAX_ACTION_AXES, MAX_ACTION_TOUCHES };
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			PODVector<SlotBinding> entries;
+			for (unsigned j = 0; j < mappings[i]->Size(); ++j)
+			{
+				const ActionMapping& mapping = (*mappings[i])[j];
+				AddSlotBinding(entries, mapping.slot_, AddAction(mapping.id_), NULL, 0);
+				entries.Back().binding_.deadZone_ = mapping.deadZone_;
+				entries.Back().binding_.exponent_ = mapping.exponent_;
+				entries.Back().binding_.scale_ = mapping.scale_;
+			}
+			BuildBindingTable(*tables[i], numSlots[i], entries);
 		}
 	}
 
+	void ActionState::AddMapping(PODVector<ActionMapping>& mappings, const String& action, unsigned slot, float deadZone, float exponent, float scale)
+	{
+		ActionMapping mapping;
+		mapping.id_ = StringHash(action);
+		mapping.slot_ = slot;
+		mapping.deadZone_ = deadZone;
+		mapping.exponent_ = exponent;
+		mapping.scale_ = scale;
+		mappings.Push(mapping);
+		actionNameMapping_[mapping.id_] = action;
+		tablesDirty_ = true;
+	}
+
+	void ActionState::AddJoystickButtonAction(const String& action, unsigned button)
+	{
+		if (button < MAX_ACTION_JOYSTICKBUTTONS)
+			AddMapping(joystickButtonMapping_, action, button);
+	}
+
+	void ActionState::AddJoystickHatAction(const String& action, unsigned hat, int direction)
+	{
+		for (unsigned bit = 0; bit < 4; ++bit)
+		{
+			if ((direction & (1 << bit)) && hat < MAX_ACTION_JOYSTICKHATS)
+				AddMapping(joystickHatMapping_, action, GetHatSlot(hat, bit));
+		}
+	}
+
+	void ActionState::AddAxisAction(const String& action, unsigned axis, float deadZone, float exponent, float scale)
+	{
+		// Joystick dead zones are a fraction of the range, the relative ones are in input units
+		if (axis < MAX_ACTION_JOYSTICKAXES)
+			AddMapping(axisMapping_, action, axis, Clamp(deadZone, 0.0f, 0.99f), exponent, scale);
+		else if (axis < MAX_ACTION_AXES)
+			AddMapping(axisMapping_, action, axis, Max(deadZone, 0.0f), exponent, scale);
+	}
+
+	void ActionState::AddTouchAction(const String& action, unsigned fingers)
+	{
+		if (fingers > 0 && fingers < MAX_ACTION_TOUCHES)
+			AddMapping(touchMapping_, action, fingers);
+	}
+
 	sInputAction::sInputAction(const String& name, int key, unsigned mouseButtons, bool repeat) : mouseButtons_(0), name_(name)
 	{
 		mouseButtons_ = mouseButtons;
@@ -5,6 +5,8 @@
 
 #include "../Core/Object.h"
 #include "../Core/Context.h"
+#include "../Math/Vector2.h"
+#include "../IO/VectorBuffer.h"
 #include "Macros.h"
 
 namespace Urho3D
@@ -14,12 +16,55 @@ namespace Urho3D
 	{
 		PARAM(P_ACTIONID, ActionID);        // StringHash
 		PARAM(P_ISDOWN, IsDown);            // bool
+		PARAM(P_VALUE, Value);              // float, 1 or 0 for digital actions, the frame delta for relative axes
 	}
 
-#define MouseButton_Mask 0x01;
-#define Key_Mask 0x02;
-#define MoveVert_Mask 0x04;
-#define MoveHori_Mask 0x08;
+	/// a replay reached the end of its recording
+	EVENT(E_INPUTREPLAYFINISHED, InputReplayFinished)
+	{
+	}
+
+#define MouseButton_Mask 0x01
+#define Key_Mask 0x02
+#define MoveVert_Mask 0x04
+#define MoveHori_Mask 0x08
+
+	/// size of the compiled key table, SDL scancodes are below this
+	static const unsigned MAX_ACTION_SCANCODES = 512;
+	/// size of the compiled mouse button table, one slot per button bit
+	static const unsigned MAX_ACTION_MOUSEBUTTONS = 8;
+	static const unsigned MAX_ACTION_JOYSTICKBUTTONS = 32;
+	/// hats have one slot per direction bit
+	static const unsigned MAX_ACTION_JOYSTICKHATS = 4;
+	static const unsigned MAX_ACTION_JOYSTICKAXES = 16;
+	/// touch chords from 1 to MAX_ACTION_TOUCHES - 1 fingers
+	static const unsigned MAX_ACTION_TOUCHES = 8;
+
+	/// analog inputs. The joystick axes 0 to MAX_ACTION_JOYSTICKAXES - 1 come first and are absolute positions,
+	/// the others are relative and add up over a frame.
+	enum ActionAxis
+	{
+		ACTION_AXIS_MOUSEX = MAX_ACTION_JOYSTICKAXES,
+		ACTION_AXIS_MOUSEY,
+		ACTION_AXIS_WHEEL,
+		/// one finger drag
+		ACTION_AXIS_TOUCHX,
+		ACTION_AXIS_TOUCHY,
+		/// change of the distance between two fingers
+		ACTION_AXIS_PINCH,
+		MAX_ACTION_AXES
+	};
+
+	/// binding of an action to a joystick, axis or touch slot, before it is compiled
+	struct ActionMapping
+	{
+		StringHash	id_;
+		unsigned	slot_;
+		/// analog response: inputs within the dead zone are 0, the rest is raised to exponent and scaled
+		float		deadZone_;
+		float		exponent_;
+		float		scale_;
+	};
 
 	struct sInputAction
 	{
@@ -46,6 +91,77 @@ namespace Urho3D
 
 
 
+	/// an action bound to one input slot of the compiled tables
+	struct ActionBinding
+	{
+		/// dense index of the action in its ActionState
+		unsigned	action_;
+		/// NULL for the plain key and mouse button actions
+		sInputAction* input_;
+		/// bit of this input in the masks of input_
+		unsigned	mask_;
+		/// analog response of axis bindings
+		float		deadZone_;
+		float		exponent_;
+		float		scale_;
+	};
+
+	/// bindings grouped by input slot, slot i owns bindings_[ranges_[i]] up to bindings_[ranges_[i + 1]]
+	struct ActionBindingTable
+	{
+		const ActionBinding* Begin(unsigned slot) const { return bindings_.Buffer() + ranges_[slot]; }
+		const ActionBinding* End(unsigned slot) const { return bindings_.Buffer() + ranges_[slot + 1]; }
+
+		PODVector<unsigned>			ranges_;
+		PODVector<ActionBinding>	bindings_;
+	};
+
+	/// action states of one frame, indexed by the dense action index of the active ActionState. Pressed and released
+	/// hold the transitions of the frame, held and the analog values the state after them.
+	class ActionSnapshot
+	{
+	public:
+		ActionSnapshot() :
+			frameNumber_(0)
+		{
+		}
+
+		bool IsPressed(unsigned action) const { return TestBit(pressed_, action); }
+		bool IsHeld(unsigned action) const { return TestBit(held_, action); }
+		bool IsReleased(unsigned action) const { return TestBit(released_, action); }
+		/// 1 or 0 for digital actions, the sum of this frame for relative axes
+		float GetValue(unsigned action) const { return action < values_.Size() ? values_[action] : 0.0f; }
+		unsigned GetFrameNumber() const { return frameNumber_; }
+
+		/// forget all actions, for a new action state
+		void Reset(unsigned numActions);
+		/// start a frame, the transitions of the last one are cleared
+		void BeginFrame(unsigned frameNumber);
+		/// press or release one binding of the action. The action stays held until all its bindings are released,
+		/// returns true if the held state changed.
+		bool SetDown(unsigned action, bool down);
+		void SetValue(unsigned action, float value);
+		/// add to a relative axis value, it is set back to 0 when the next frame begins. The action counts as pressed.
+		void AddValue(unsigned action, float delta);
+
+	protected:
+		static bool TestBit(const PODVector<unsigned>& bits, unsigned index)
+		{
+			return (index >> 5) < bits.Size() && (bits[index >> 5] & (1u << (index & 31))) != 0;
+		}
+		void Grow(unsigned numActions);
+
+		PODVector<unsigned>	pressed_;
+		PODVector<unsigned>	held_;
+		PODVector<unsigned>	released_;
+		/// actions whose value is a per-frame sum
+		PODVector<unsigned>	relative_;
+		PODVector<float>	values_;
+		/// bindings holding every action
+		PODVector<unsigned char>	downCounts_;
+		unsigned			frameNumber_;
+	};
+
 	class ActionState : public Object
 	{
 		OBJECT(ActionState);
@@ -62,12 +178,42 @@ namespace Urho3D
 		void AddInputState(sInputAction* inAction);
 		void AddKeyAction(const String& action, int key);
 		void AddMouseButtonAction(const String& action, unsigned mouseButton);
+		void AddJoystickButtonAction(const String& action, unsigned button);
+		/// hat direction is one of the HAT_UP, HAT_RIGHT, HAT_DOWN and HAT_LEFT bits
+		void AddJoystickHatAction(const String& action, unsigned hat, int direction);
+		/// analog action, it is also held while its value is not 0. Joystick axes are passed by number.
+		void AddAxisAction(const String& action, unsigned axis, float deadZone = 0.0f, float exponent = 1.0f, float scale = 1.0f);
+		/// held while exactly fingers fingers touch
+		void AddTouchAction(const String& action, unsigned fingers);
 
 		const String&		GetName() { return name_; }
 		const StringHash&	GetID() { return nameHash_; }
 		const String&		GetActionName(const StringHash& actionId);
 
+		/// number of distinct actions, their dense indices go from 0 to this
+		unsigned			GetNumActions();
+		/// id of the action with the dense index
+		StringHash			GetActionID(unsigned index);
+		/// dense index of the action, M_MAX_UNSIGNED if it is not bound
+		unsigned			GetActionIndex(StringHash actionId);
+		/// key bindings indexed by scancode, rebuilt after the mappings changed
+		const ActionBindingTable& GetKeyTable();
+		/// mouse button bindings indexed by button bit
+		const ActionBindingTable& GetMouseButtonTable();
+		const ActionBindingTable& GetJoystickButtonTable();
+		/// joystick hat bindings indexed by hat * 4 + direction bit
+		const ActionBindingTable& GetJoystickHatTable();
+		/// analog bindings indexed by ActionAxis
+		const ActionBindingTable& GetAxisTable();
+		/// touch chord bindings indexed by finger count
+		const ActionBindingTable& GetTouchTable();
+
 	protected:
+		/// dense index of the action, added if new
+		unsigned AddAction(StringHash id);
+		/// build the flat tables from the mappings
+		void CompileTables();
+		void AddMapping(PODVector<ActionMapping>& mappings, const String& action, unsigned slot, float deadZone = 0.0f, float exponent = 1.0f, float scale = 1.0f);
 
 		StringHash	nameHash_;
 		String		name_;
@@ -79,6 +225,22 @@ namespace Urho3D
 		HashMap<unsigned, HashSet< StringHash> >	mouseButtonMapping_;
 
 		HashMap<StringHash, String>		actionNameMapping_;
+
+		PODVector<ActionMapping>		joystickButtonMapping_;
+		PODVector<ActionMapping>		joystickHatMapping_;
+		PODVector<ActionMapping>		axisMapping_;
+		PODVector<ActionMapping>		touchMapping_;
+
+		/// compiled from the mappings on first use after a change
+		Vector<StringHash>				actions_;
+		HashMap<StringHash, unsigned>	actionIndices_;
+		ActionBindingTable				keyTable_;
+		ActionBindingTable				mouseButtonTable_;
+		ActionBindingTable				joystickButtonTable_;
+		ActionBindingTable				joystickHatTable_;
+		ActionBindingTable				axisTable_;
+		ActionBindingTable				touchTable_;
+		bool							tablesDirty_;
 	};
 
 
@@ -101,6 +263,30 @@ namespace Urho3D
 		/// Returns the active actions state
 		ActionState* Get();
 
+		/// actions of this frame for the active state, the transitions are those since the frame began
+		const ActionSnapshot& GetSnapshot();
+		bool IsPressed(StringHash actionId) { return GetSnapshot().IsPressed(GetActionIndex(actionId)); }
+		bool IsHeld(StringHash actionId) { return GetSnapshot().IsHeld(GetActionIndex(actionId)); }
+		bool IsReleased(StringHash actionId) { return GetSnapshot().IsReleased(GetActionIndex(actionId)); }
+		float GetValue(StringHash actionId) { return GetSnapshot().GetValue(GetActionIndex(actionId)); }
+		/// dense index of the action in the active state, for polling without the hash lookup
+		unsigned GetActionIndex(StringHash actionId) { return currentState_ ? currentState_->GetActionIndex(actionId) : M_MAX_UNSIGNED; }
+
+		/// send E_INPUTACTION for every action transition, off for code that only polls
+		U_PROPERTY_IMP(bool, sendEvents_, SendEvents)
+
+		/// record the input events and the actions from the next frame on
+		void StartRecording();
+		void StopRecording();
+		bool IsRecording() const { return isRecording_; }
+		/// recorded stream: per record the frame offset to the previous one, the record type and its values
+		const PODVector<unsigned char>& GetRecording() const { return recording_.GetBuffer(); }
+		/// feed the recorded input events back from the next frame on, each in the frame it was recorded in. Live input is
+		/// ignored until the replay finishes or is stopped.
+		void StartReplay(const PODVector<unsigned char>& recording);
+		void StopReplay();
+		bool IsReplaying() const { return isReplaying_; }
+
 	protected:
 		
 		void HandleMouseButtonDown(StringHash eventType, VariantMap& eventData);
@@ -121,10 +307,58 @@ namespace Urho3D
 		void HandleTouchBegin(StringHash eventType, VariantMap& eventData);
 		void HandleTouchMove(StringHash eventType, VariantMap& eventData);
 
+		/// update the inputs of the bindings and send the actions that changed
+		void DispatchBindings(const ActionBinding* begin, const ActionBinding* end, bool down);
+		/// apply an absolute axis position to its bindings
+		void DispatchAxis(unsigned axis, float position);
+		/// apply a relative axis delta to its bindings
+		void DispatchRelativeAxis(unsigned axis, float delta);
+		/// release the chord of the old finger count and press the one of the new
+		void DispatchTouchCount(unsigned oldCount, unsigned newCount);
+		/// record the action transition and send it if events are on
+		void NotifyAction(StringHash actionId, bool down, float value);
+
+		/// false for live input during a replay, records the input when recording
+		bool AcceptInput(StringHash eventType, VariantMap& eventData);
+		void WriteRecordHeader(unsigned type);
+		/// forget the held inputs, so a replay starts like the recording did
+		void ResetInputState();
+		/// inject the records of this frame
+		void HandleReplayFrame(StringHash eventType, VariantMap& eventData);
+		/// record the transition in the snapshot and send it
+		void SetActionDown(unsigned action, bool down);
+		/// make the active state current, the snapshot starts over
+		void SetCurrentState(ActionState* state);
+
 		/// Active finger touches.
 		HashMap<StringHash, ActionState*> actionStates_;
 		Vector<ActionState*>	stack_;
 		ActionState*			currentState_;
+		ActionSnapshot			snapshot_;
+		/// last response of every axis binding, indexed like the axis table
+		PODVector<float>		axisValues_;
+
+		struct TouchPoint
+		{
+			int			id_;
+			IntVector2	position_;
+		};
+		/// fingers down, in the order they touched
+		PODVector<TouchPoint>	touches_;
+		/// last position of every hat
+		int						hatPositions_[MAX_ACTION_JOYSTICKHATS];
+
+		VectorBuffer	recording_;
+		bool			isRecording_;
+		/// frame of the last record, the stream stores frame offsets
+		unsigned		recordFrame_;
+		VectorBuffer	replay_;
+		bool			isReplaying_;
+		/// set while a replayed event is handled
+		bool			injecting_;
+		unsigned		replayFrame_;
+		/// frame of the next record, M_MAX_UNSIGNED before its header is read
+		unsigned		nextReplayFrame_;
 	};
 
 
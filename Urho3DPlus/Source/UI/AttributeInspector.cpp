@@ -37,6 +37,7 @@
 #include "../UI/DropDownList.h"
 #include "../Scene/Node.h"
 #include "../Scene/Component.h"
+#include "../Editor/EditorSelection.h"
 #include "../UI/DropDownList.h"
 #include "../Resource/XMLFile.h"
 #include "../UI/Window.h"
@@ -224,20 +225,23 @@ namespace Urho3D
 
 	void AttributeInspector::Update(bool fullUpdate /*= true*/)
 	{
+		const Vector<Node*>& editNodes = GetInspectedNodes();
+		const Vector<Component*>& editComponents = GetInspectedComponents();
+
 		attributesDirty_ = false;
 		if (fullUpdate)
 			attributesFullDirty_ = false;
 
 		DisableAllContainers();
 
-		if (!editNodes_.Empty())
+		if (!editNodes.Empty())
 		{
 		//	Vector<Serializable*> nodes = UIUtils::ToSerializableArray(editorData_->GetEditNodes());
-			AttributeContainer* nodeContainer = CreateNodeContainer(editNodes_[0]);
+			AttributeContainer* nodeContainer = CreateNodeContainer(editNodes[0]);
 			nodeContainer->SetVisible(true);
 			nodeContainer->SetEnabled(true);
 
-			Node* editNode = editNodes_[0];
+			Node* editNode = editNodes[0];
 			if (editNode != NULL)
 			{
 				String idStr;
@@ -250,18 +254,18 @@ namespace Urho3D
 			}
 			else
 			{
-				nodeContainer->SetTitle(editNodes_[0]->GetTypeName() + " (ID -- : " + String(editNodes_.Size()) + "x)");
+				nodeContainer->SetTitle(editNodes[0]->GetTypeName() + " (ID -- : " + String(editNodes.Size()) + "x)");
 			}
 
-			nodeContainer->SetSerializableAttributes(editNodes_[0]);
+			nodeContainer->SetSerializableAttributes(editNodes[0]);
 		}
 
-		if (!editComponents_.Empty())
+		if (!editComponents.Empty())
 		{
 	
-			for (unsigned int j = 0; j < editComponents_.Size(); ++j)
+			for (unsigned int j = 0; j < editComponents.Size(); ++j)
 			{
-				Component* comp = editComponents_[j ];
+				Component* comp = editComponents[j ];
 
 				AttributeContainer* container = CreateComponentContainer(comp);
 
@@ -354,7 +358,8 @@ namespace Urho3D
 
 	void AttributeInspector::CreateNodeVariable(StringHash eventType, VariantMap& eventData)
 	{
-		if (editNodes_.Empty())
+		const Vector<Node*>& editNodes = GetInspectedNodes();
+		if (editNodes.Empty())
 			return;
 		LineEdit* editName = NULL;
 		String newName = ExtractVariableName(eventData, editName);
@@ -362,21 +367,21 @@ namespace Urho3D
 			return;
 
 		// Create scene variable
-		editNodes_[0]->GetScene()->RegisterVar(newName);
+		editNodes[0]->GetScene()->RegisterVar(newName);
 
 
 		Variant newValue = ExtractVariantType(eventData);
 
 		// If we overwrite an existing variable, must recreate the attribute-editor(s) for the correct type
 		bool overwrite = false;
-		for (unsigned int i = 0; i < editNodes_.Size(); ++i)
+		for (unsigned int i = 0; i < editNodes.Size(); ++i)
 		{
-			overwrite = overwrite || editNodes_[i]->GetVars().Contains(newName);
-			editNodes_[i]->SetVar(newName, newValue);
+			overwrite = overwrite || editNodes[i]->GetVars().Contains(newName);
+			editNodes[i]->SetVar(newName, newValue);
 		}
 
-		AttributeContainer* nodeContainer = CreateNodeContainer(editNodes_[0]);
-		nodeContainer->UpdateVariantMap(editNodes_[0]);
+		AttributeContainer* nodeContainer = CreateNodeContainer(editNodes[0]);
+		nodeContainer->UpdateVariantMap(editNodes[0]);
 
 		if (editName)
 			editName->SetText("");
@@ -384,7 +389,8 @@ namespace Urho3D
 
 	void AttributeInspector::DeleteNodeVariable(StringHash eventType, VariantMap& eventData)
 	{
-		if (editNodes_.Empty())
+		const Vector<Node*>& editNodes = GetInspectedNodes();
+		if (editNodes.Empty())
 			return;
 		LineEdit* editName = NULL;
 
@@ -395,7 +401,7 @@ namespace Urho3D
 		// Note: intentionally do not unregister the variable name here as the same variable name may still be used by other attribute list
 
 		bool erased = false;
-		for (unsigned int i = 0; i < editNodes_.Size(); ++i)
+		for (unsigned int i = 0; i < editNodes.Size(); ++i)
 		{
 			// \todo Should first check whether var in question is editable
 			//	erased = editorData_->GetEditNodes()[i].GetVars().Erase(delName) || erased;
@@ -435,6 +441,21 @@ namespace Urho3D
 		return editNodes_;
 	}
 
+	void AttributeInspector::SetEditorSelection(EditorSelection* selection)
+	{
+		editorSelection_ = selection;
+	}
+
+	const Vector<Node*>& AttributeInspector::GetInspectedNodes()
+	{
+		return editorSelection_ != NULL ? editorSelection_->GetEditNodes() : editNodes_;
+	}
+
+	const Vector<Component*>& AttributeInspector::GetInspectedComponents()
+	{
+		return editorSelection_ != NULL ? editorSelection_->GetEditComponents() : editComponents_;
+	}
+
 	Vector<Component*>& AttributeInspector::GetEditComponents()
 	{
 		return editComponents_;
@@ -51,6 +51,7 @@ namespace Urho3D
 
 	class AttributeContainer;
 	class ResourcePickerManager;
+	class EditorSelection;
 
 	/// \todo Serialization
 	class AttributeInspector : public Object
@@ -78,7 +79,13 @@ namespace Urho3D
 		Vector<Node*>&		GetEditNodes();
 		Vector<Component*>& GetEditComponents();
 		Vector<UIElement*>&	GetEditUIElements();
+		/// inspect the edit objects of the selection directly instead of the lists above, so that a selection change
+		/// does not copy them
+		void SetEditorSelection(EditorSelection* selection);
 	protected:
+		/// edit nodes and components of the selection if one is set, otherwise the lists above
+		const Vector<Node*>&		GetInspectedNodes();
+		const Vector<Component*>&	GetInspectedComponents();
 		/// Get node container in the inspector list, create the container if it is not yet available.
 		AttributeContainer* CreateNodeContainer(Serializable* serializable);
 		bool				DeleteNodeContainer(Serializable* serializable);
@@ -150,6 +157,7 @@ namespace Urho3D
 		Vector<Node*>		editNodes_;
 		Vector<Component*>	editComponents_;
 		Vector<UIElement*>	editUIElements_;
+		WeakPtr<EditorSelection> editorSelection_;
 
 		SharedPtr<FileSelector> uiFileSelector_;
 	};
@@ -413,6 +413,31 @@ namespace Urho3D
 		UpdateHierarchyItem(GetListIndex(serializable), serializable, parentItem);
 	}
 
+	void HierarchyWindow::AddHierarchyItems(const PODVector<Node*>& nodes)
+	{
+		// Nested layout updates are no-ops until the outermost one is re-enabled
+		hierarchyList_->GetContentElement()->DisableLayoutUpdate();
+
+		Node* lastParent = NULL;
+		UIElement* parentItem = NULL;
+		for (unsigned int i = 0; i < nodes.Size(); ++i)
+		{
+			Node* node = nodes[i];
+			if (node == NULL || (!showTemporaryObject_ && node->IsTemporary()))
+				continue;
+
+			if (node->GetParent() != lastParent || parentItem == NULL)
+			{
+				lastParent = node->GetParent();
+				parentItem = hierarchyList_->GetItem(GetListIndex(lastParent));
+			}
+			UpdateHierarchyItem(NO_ITEM, node, parentItem);
+		}
+
+		hierarchyList_->GetContentElement()->EnableLayoutUpdate();
+		hierarchyList_->GetContentElement()->UpdateLayout();
+	}
+
 	void HierarchyWindow::SetTitleBarVisible(bool show)
 	{
 		img_->SetVisible(show);
@@ -688,6 +713,24 @@ namespace Urho3D
 		return NO_ITEM;
 	}
 
+	void HierarchyWindow::GetListIndices(const HashSet<unsigned>& nodeIDs, const HashSet<unsigned>& componentIDs, PODVector<unsigned>& indices)
+	{
+		indices.Clear();
+		if (nodeIDs.Empty() && componentIDs.Empty())
+			return;
+
+		unsigned int numItems = hierarchyList_->GetNumItems();
+		for (unsigned int i = 0; i < numItems; ++i)
+		{
+			UIElement* item = hierarchyList_->GetItem(i);
+			int itemType = item->GetVar(TYPE_VAR).GetInt();
+			if (itemType == ITEM_NODE && nodeIDs.Contains(item->GetVar(NODE_ID_VAR).GetUInt()))
+				indices.Push(i);
+			else if (itemType == ITEM_COMPONENT && componentIDs.Contains(item->GetVar(COMPONENT_ID_VAR).GetUInt()))
+				indices.Push(i);
+		}
+	}
+
 	Scene* HierarchyWindow::GetScene()
 	{
 		return scene_;
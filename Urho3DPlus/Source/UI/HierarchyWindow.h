@@ -4,6 +4,7 @@
 #include "../Urho3D.h"
 #include "../UI/Window.h"
 #include "../Core/Context.h"
+#include "../Container/HashSet.h"
 #include "Utils/Macros.h"
 #include "UIGlobals.h"
 
@@ -36,6 +37,8 @@ namespace Urho3D
 
 		/// Update 
 		void UpdateHierarchyItem(Serializable* serializable, bool clear = false);
+		/// add newly created nodes with a single layout update, parent items are looked up once per run of siblings
+		void AddHierarchyItems(const PODVector<Node*>& nodes);
 		void SetTitleBarVisible(bool show);
 		/// Setters
 		void SetTitle(const String& title);
@@ -49,6 +52,8 @@ namespace Urho3D
 		const String&	GetTitle();
 		unsigned int	GetListIndex(Serializable* serializable);
 		unsigned int	GetComponentListIndex(Component* component);
+		/// list indices of the nodes and components with the given IDs, all found in one pass over the list
+		void			GetListIndices(const HashSet<unsigned>& nodeIDs, const HashSet<unsigned>& componentIDs, PODVector<unsigned>& indices);
 		Scene*			GetScene();
 		UIElement*		GetUIElement();
 		XMLFile*		GetIconStyle();
@@ -0,0 +1,458 @@
+#include "SceneStatsWindow.h"
+#include "../UI/Text.h"
+#include "../UI/Button.h"
+#include "../UI/ListView.h"
+#include "../UI/UIEvents.h"
+#include "../Scene/SceneEvents.h"
+#include "../Scene/Node.h"
+#include "../Scene/Component.h"
+#include "../Scene/Scene.h"
+#include "../Graphics/Drawable.h"
+#include "../Graphics/Geometry.h"
+#include "../Graphics/Light.h"
+#include "../Graphics/Octree.h"
+#include "../Graphics/OctreeQuery.h"
+#include "../Graphics/Renderer.h"
+#include "../Math/Sphere.h"
+#include "UIUtils.h"
+
+namespace Urho3D
+{
+	static const char* statsColumnNames[] = {
+		"Tris",
+		"Batches",
+		"Mats",
+		"Lit",
+		"Shadow"
+	};
+
+	static const StringHash STATS_NODE_ID_VAR("StatsNodeID");
+	static const StringHash STATS_COLUMN_VAR("StatsColumn");
+
+	SceneStatsWindow::SceneStatsWindow(Context* context) : Window(context),
+		maxRows_(100),
+		refreshInterval_(0.5f),
+		sortColumn_(STATS_TRIANGLES),
+		listDirty_(true),
+		refreshTimer_(0.0f)
+	{
+		SetLayout(LM_VERTICAL, 4, IntRect(6, 6, 6, 6));
+		SetResizeBorder(IntRect(6, 6, 6, 6));
+		SetResizable(true);
+		SetName("SceneStatsWindow");
+
+		UIElement* toolBar = CreateChild<UIElement>("SSW_ToolBar");
+		toolBar->SetInternal(true);
+		toolBar->SetFixedHeight(17);
+		toolBar->SetLayoutMode(LM_HORIZONTAL);
+		toolBar->SetLayoutSpacing(4);
+
+		for (unsigned i = 0; i < MAX_STATS_COLUMNS; ++i)
+		{
+			sortButtons_[i] = toolBar->CreateChild<Button>("SSW_Sort" + String(statsColumnNames[i]));
+			sortButtons_[i]->SetInternal(true);
+			sortButtons_[i]->SetFixedHeight(17);
+			sortButtons_[i]->SetMinWidth(40);
+			sortButtons_[i]->SetLayoutMode(LM_HORIZONTAL);
+			sortButtons_[i]->SetLayoutBorder(IntRect(1, 1, 1, 1));
+			sortButtons_[i]->SetVar(STATS_COLUMN_VAR, i);
+			Text* label = sortButtons_[i]->CreateChild<Text>();
+			label->SetInternal(true);
+			label->SetText(statsColumnNames[i]);
+			SubscribeToEvent(sortButtons_[i], E_RELEASED, HANDLER(SceneStatsWindow, HandleSortButton));
+		}
+
+		refreshButton_ = toolBar->CreateChild<Button>("SSW_RefreshButton");
+		refreshButton_->SetInternal(true);
+		refreshButton_->SetFixedHeight(17);
+		refreshButton_->SetMinWidth(60);
+		refreshButton_->SetLayoutMode(LM_HORIZONTAL);
+		refreshButton_->SetLayoutBorder(IntRect(1, 1, 1, 1));
+		Text* label = refreshButton_->CreateChild<Text>();
+		label->SetInternal(true);
+		label->SetText("Refresh");
+		SubscribeToEvent(refreshButton_, E_RELEASED, HANDLER(SceneStatsWindow, HandleRefreshButton));
+
+		totalsText_ = CreateChild<Text>("SSW_TotalsText");
+		totalsText_->SetInternal(true);
+
+		statsList_ = CreateChild<ListView>("SSW_ListView");
+		statsList_->SetInternal(true);
+		statsList_->SetHighlightMode(HM_ALWAYS);
+	}
+
+	SceneStatsWindow::~SceneStatsWindow()
+	{
+	}
+
+	void SceneStatsWindow::RegisterObject(Context* context)
+	{
+		context->RegisterFactory<SceneStatsWindow>();
+		COPY_BASE_ATTRIBUTES(Window);
+		ACCESSOR_ATTRIBUTE("Max Rows", GetMaxRows, SetMaxRows, unsigned, 100, AM_DEFAULT);
+		ACCESSOR_ATTRIBUTE("Refresh Interval", GetRefreshInterval, SetRefreshInterval, float, 0.5f, AM_DEFAULT);
+	}
+
+	void SceneStatsWindow::SetScene(Scene* scene)
+	{
+		if (scene_ != NULL)
+		{
+			UnsubscribeFromEvent(scene_, E_NODEADDED);
+			UnsubscribeFromEvent(scene_, E_NODEREMOVED);
+			UnsubscribeFromEvent(scene_, E_COMPONENTADDED);
+			UnsubscribeFromEvent(scene_, E_COMPONENTREMOVED);
+			UnsubscribeFromEvent(scene_, E_ASYNCLOADFINISHED);
+		}
+
+		scene_ = scene;
+
+		if (scene_ != NULL)
+		{
+			SubscribeToEvent(scene_, E_NODEADDED, HANDLER(SceneStatsWindow, HandleNodeAdded));
+			SubscribeToEvent(scene_, E_NODEREMOVED, HANDLER(SceneStatsWindow, HandleNodeRemoved));
+			SubscribeToEvent(scene_, E_COMPONENTADDED, HANDLER(SceneStatsWindow, HandleComponentAdded));
+			SubscribeToEvent(scene_, E_COMPONENTREMOVED, HANDLER(SceneStatsWindow, HandleComponentRemoved));
+			SubscribeToEvent(scene_, E_ASYNCLOADFINISHED, HANDLER(SceneStatsWindow, HandleAsyncLoadFinished));
+		}
+
+		Refresh();
+	}
+
+	void SceneStatsWindow::Refresh()
+	{
+		stats_.Clear();
+		dirtyNodes_.Clear();
+		if (scene_ != NULL)
+			UpdateSubtree(scene_);
+		listDirty_ = true;
+		refreshTimer_ = refreshInterval_;
+	}
+
+	void SceneStatsWindow::SetSortColumn(SceneStatsColumn column)
+	{
+		if (column < MAX_STATS_COLUMNS && column != sortColumn_)
+		{
+			sortColumn_ = column;
+			listDirty_ = true;
+			refreshTimer_ = refreshInterval_;
+		}
+	}
+
+	void SceneStatsWindow::Update(float timeStep)
+	{
+		refreshTimer_ += timeStep;
+		if (refreshTimer_ < refreshInterval_ || !IsVisible())
+			return;
+
+		UpdateDirtyNodes();
+		if (!listDirty_)
+			return;
+
+		refreshTimer_ = 0.0f;
+		RebuildList();
+		listDirty_ = false;
+	}
+
+	const SceneStatsCost* SceneStatsWindow::GetSubtreeCost(Node* node) const
+	{
+		if (node == NULL)
+			return NULL;
+
+		HashMap<unsigned, NodeStats>::ConstIterator i = stats_.Find(node->GetID());
+		return i != stats_.End() ? &i->second_.subtree_ : NULL;
+	}
+
+	Node* SceneStatsWindow::GetItemNode(UIElement* item) const
+	{
+		if (item == NULL || scene_ == NULL)
+			return NULL;
+
+		return scene_->GetNode(item->GetVar(STATS_NODE_ID_VAR).GetUInt());
+	}
+
+	void SceneStatsWindow::UpdateNode(Node* node)
+	{
+		SceneStatsCost cost;
+		ComputeCost(node, cost);
+
+		NodeStats& stats = stats_[node->GetID()];
+		stats.node_ = node;
+
+		SceneStatsCost delta;
+		bool changed = false;
+		for (unsigned i = 0; i < MAX_STATS_COLUMNS; ++i)
+		{
+			delta.values_[i] = cost.values_[i] - stats.own_.values_[i];
+			changed |= delta.values_[i] != 0;
+		}
+
+		if (changed)
+		{
+			stats.own_ = cost;
+			ApplyDelta(node, delta);
+		}
+	}
+
+	void SceneStatsWindow::UpdateSubtree(Node* node)
+	{
+		UpdateNode(node);
+
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned i = 0; i < children.Size(); ++i)
+			UpdateSubtree(children[i]);
+	}
+
+	void SceneStatsWindow::TrackSubtree(Node* node)
+	{
+		// The ancestors have entries before any cost is applied, so the dirty nodes can be counted in any order
+		if (!stats_.Contains(node->GetID()))
+			stats_[node->GetID()].node_ = node;
+		dirtyNodes_.Insert(node->GetID());
+
+		const Vector<SharedPtr<Node> >& children = node->GetChildren();
+		for (unsigned i = 0; i < children.Size(); ++i)
+			TrackSubtree(children[i]);
+	}
+
+	void SceneStatsWindow::UpdateDirtyNodes()
+	{
+		// A loading scene is counted as a whole once it is finished
+		if (dirtyNodes_.Empty() || scene_ == NULL || scene_->IsAsyncLoading())
+			return;
+
+		for (HashSet<unsigned>::ConstIterator i = dirtyNodes_.Begin(); i != dirtyNodes_.End(); ++i)
+		{
+			// Removed nodes have been taken off the totals already
+			Node* node = scene_->GetNode(*i);
+			if (node != NULL && stats_.Contains(*i))
+				UpdateNode(node);
+		}
+		dirtyNodes_.Clear();
+	}
+
+	void SceneStatsWindow::RemoveSubtree(Node* node, Node* parent)
+	{
+		HashMap<unsigned, NodeStats>::Iterator i = stats_.Find(node->GetID());
+		if (i == stats_.End())
+			return;
+
+		// The subtree total already holds the children, take it off the ancestors once and forget the whole subtree
+		SceneStatsCost delta;
+		for (unsigned j = 0; j < MAX_STATS_COLUMNS; ++j)
+			delta.values_[j] = -i->second_.subtree_.values_[j];
+		if (parent != NULL)
+			ApplyDelta(parent, delta);
+
+		PODVector<Node*> nodes;
+		node->GetChildren(nodes, true);
+		stats_.Erase(i);
+		for (unsigned j = 0; j < nodes.Size(); ++j)
+			stats_.Erase(nodes[j]->GetID());
+	}
+
+	void SceneStatsWindow::ApplyDelta(Node* node, const SceneStatsCost& delta)
+	{
+		for (; node != NULL; node = node->GetParent())
+		{
+			HashMap<unsigned, NodeStats>::Iterator i = stats_.Find(node->GetID());
+			if (i == stats_.End())
+				continue;
+
+			for (unsigned j = 0; j < MAX_STATS_COLUMNS; ++j)
+				i->second_.subtree_.values_[j] += delta.values_[j];
+		}
+
+		listDirty_ = true;
+	}
+
+	void SceneStatsWindow::ComputeCost(Node* node, SceneStatsCost& cost)
+	{
+		const Vector<SharedPtr<Component> >& components = node->GetComponents();
+		PODVector<Material*> materials;
+
+		for (unsigned i = 0; i < components.Size(); ++i)
+		{
+			Component* component = components[i];
+			if (component->GetType() == Light::GetTypeStatic())
+			{
+				cost.values_[STATS_LIT] += CountLitDrawables(component);
+				continue;
+			}
+
+			Drawable* drawable = dynamic_cast<Drawable*>(component);
+			if (drawable == NULL || !(drawable->GetDrawableFlags() & DRAWABLE_GEOMETRY))
+				continue;
+
+			const Vector<SourceBatch>& batches = drawable->GetBatches();
+			cost.values_[STATS_BATCHES] += batches.Size();
+			for (unsigned j = 0; j < batches.Size(); ++j)
+			{
+				Geometry* geometry = batches[j].geometry_;
+				if (geometry != NULL)
+					cost.values_[STATS_TRIANGLES] += (geometry->GetIndexCount() ? geometry->GetIndexCount() : geometry->GetVertexCount()) / 3;
+
+				Material* material = batches[j].material_;
+				if (material != NULL && !materials.Contains(material))
+					materials.Push(material);
+			}
+
+			if (drawable->GetCastShadows())
+				++cost.values_[STATS_SHADOWCASTERS];
+		}
+
+		cost.values_[STATS_MATERIALS] = materials.Size();
+	}
+
+	int SceneStatsWindow::CountLitDrawables(Component* component)
+	{
+		Light* light = static_cast<Light*>(component);
+		Octree* octree = scene_ != NULL ? scene_->GetComponent<Octree>() : NULL;
+		if (octree == NULL || light->GetNode() == NULL)
+			return 0;
+
+		drawables_.Clear();
+		switch (light->GetLightType())
+		{
+		case LIGHT_DIRECTIONAL:
+		{
+			AllContentOctreeQuery query(drawables_, DRAWABLE_GEOMETRY);
+			octree->GetDrawables(query);
+			break;
+		}
+
+		case LIGHT_SPOT:
+		{
+			FrustumOctreeQuery query(drawables_, light->GetFrustum(), DRAWABLE_GEOMETRY);
+			octree->GetDrawables(query);
+			break;
+		}
+
+		default:
+		{
+			SphereOctreeQuery query(drawables_, Sphere(light->GetNode()->GetWorldPosition(), light->GetRange()), DRAWABLE_GEOMETRY);
+			octree->GetDrawables(query);
+			break;
+		}
+		}
+
+		int count = 0;
+		for (unsigned i = 0; i < drawables_.Size(); ++i)
+		{
+			if (drawables_[i]->GetLightMask() & light->GetLightMask())
+				++count;
+		}
+		return count;
+	}
+
+	void SceneStatsWindow::RebuildList()
+	{
+		ranked_.Clear();
+		for (HashMap<unsigned, NodeStats>::Iterator i = stats_.Begin(); i != stats_.End(); ++i)
+		{
+			// The scene total is shown above the list
+			if (i->second_.node_ != NULL && i->second_.node_ != scene_)
+				ranked_.Push(&i->second_);
+		}
+
+		// Ranking only needs the top rows, move them to the front and sort just those
+		unsigned numRows = Min(maxRows_, ranked_.Size());
+		for (unsigned i = 0; i < numRows; ++i)
+		{
+			unsigned best = i;
+			int bestValue = ranked_[i]->subtree_.values_[sortColumn_];
+			for (unsigned j = i + 1; j < ranked_.Size(); ++j)
+			{
+				if (ranked_[j]->subtree_.values_[sortColumn_] > bestValue)
+				{
+					best = j;
+					bestValue = ranked_[j]->subtree_.values_[sortColumn_];
+				}
+			}
+			Swap(ranked_[i], ranked_[best]);
+		}
+
+		const SceneStatsCost* total = GetSubtreeCost(scene_);
+		Renderer* renderer = GetSubsystem<Renderer>();
+		String totals;
+		if (total != NULL)
+		{
+			totals = "Scene:";
+			for (unsigned i = 0; i < MAX_STATS_COLUMNS; ++i)
+				totals += " " + String(statsColumnNames[i]) + " " + String(total->values_[i]);
+		}
+		if (renderer != NULL)
+			totals += "\nRendered: Tris " + String(renderer->GetNumPrimitives()) + " Batches " + String(renderer->GetNumBatches());
+		totalsText_->SetText(totals);
+
+		statsList_->GetContentElement()->DisableLayoutUpdate();
+		statsList_->RemoveAllItems();
+		for (unsigned i = 0; i < numRows; ++i)
+		{
+			NodeStats* stats = ranked_[i];
+			String line = UIUtils::GetNodeTitle(stats->node_);
+			for (unsigned j = 0; j < MAX_STATS_COLUMNS; ++j)
+				line += "  " + String(stats->subtree_.values_[j]);
+
+			Text* text = new Text(context_);
+			statsList_->InsertItem(M_MAX_UNSIGNED, text);
+			text->SetStyle("FileSelectorListText");
+			text->SetText(line);
+			text->SetVar(STATS_NODE_ID_VAR, stats->node_->GetID());
+		}
+		statsList_->GetContentElement()->EnableLayoutUpdate();
+		statsList_->GetContentElement()->UpdateLayout();
+	}
+
+	void SceneStatsWindow::HandleNodeAdded(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace NodeAdded;
+		// The attributes of a created or loaded node are set after this event, count it in the next update
+		Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+		if (node != NULL)
+			TrackSubtree(node);
+	}
+
+	void SceneStatsWindow::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace NodeRemoved;
+		Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+		Node* parent = static_cast<Node*>(eventData[P_PARENT].GetPtr());
+		if (node != NULL)
+			RemoveSubtree(node, parent);
+	}
+
+	void SceneStatsWindow::HandleComponentAdded(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ComponentAdded;
+		Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+		if (node != NULL)
+			dirtyNodes_.Insert(node->GetID());
+	}
+
+	void SceneStatsWindow::HandleComponentRemoved(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace ComponentRemoved;
+		Node* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+		// The component is still attached while the event is sent, it is gone by the next update
+		if (node != NULL)
+			dirtyNodes_.Insert(node->GetID());
+	}
+
+	void SceneStatsWindow::HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData)
+	{
+		Refresh();
+	}
+
+	void SceneStatsWindow::HandleSortButton(StringHash eventType, VariantMap& eventData)
+	{
+		using namespace Released;
+		UIElement* button = static_cast<UIElement*>(eventData[P_ELEMENT].GetPtr());
+		if (button != NULL)
+			SetSortColumn((SceneStatsColumn)button->GetVar(STATS_COLUMN_VAR).GetUInt());
+	}
+
+	void SceneStatsWindow::HandleRefreshButton(StringHash eventType, VariantMap& eventData)
+	{
+		Refresh();
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+
+#include "../Urho3D.h"
+#include "../UI/Window.h"
+#include "../Core/Context.h"
+#include "../Container/HashMap.h"
+#include "../Container/HashSet.h"
+#include "Utils/Macros.h"
+#include "UIGlobals.h"
+
+
+namespace Urho3D
+{
+	class Text;
+	class Button;
+	class ListView;
+	class Node;
+	class Scene;
+	class Component;
+	class Drawable;
+
+	/// columns of the scene statistics, also the sort keys
+	enum SceneStatsColumn
+	{
+		STATS_TRIANGLES = 0,
+		STATS_BATCHES,
+		STATS_MATERIALS,
+		STATS_LIT,
+		STATS_SHADOWCASTERS,
+		MAX_STATS_COLUMNS
+	};
+
+	/// render cost of a node or a subtree
+	struct SceneStatsCost
+	{
+		SceneStatsCost()
+		{
+			for (unsigned i = 0; i < MAX_STATS_COLUMNS; ++i)
+				values_[i] = 0;
+		}
+
+		/// triangles, batches, materials, drawables lit by the lights, shadow casters
+		int values_[MAX_STATS_COLUMNS];
+	};
+
+	/// lists the most expensive subtrees of a scene. Costs are kept per node and updated incrementally: the scene events only
+	/// mark nodes dirty, Update() recomputes them once their attributes are loaded and adds the change to the subtree totals
+	/// of all ancestors.
+	class SceneStatsWindow : public Window
+	{
+		OBJECT(SceneStatsWindow);
+	public:
+		/// Construct.
+		SceneStatsWindow(Context* context);
+		/// Destruct.
+		virtual ~SceneStatsWindow();
+		/// Register object factory.
+		static void RegisterObject(Context* context);
+
+		/// track the scene, rebuilds all statistics
+		void SetScene(Scene* scene);
+		/// recompute all statistics, needed after changes that send no scene event (e.g. model or light range changes)
+		void Refresh();
+		/// set the column the list is sorted by
+		void SetSortColumn(SceneStatsColumn column);
+		/// recompute the dirty nodes and refresh the list if the statistics changed, at most refreshInterval_ seconds apart
+		void Update(float timeStep);
+
+		/// return the subtree cost of the node, NULL if the node is not tracked
+		const SceneStatsCost* GetSubtreeCost(Node* node) const;
+		ListView* GetStatsList() { return statsList_; }
+		/// return the node of a list item, NULL if it was removed
+		Node* GetItemNode(UIElement* item) const;
+
+		U_PROPERTY_IMP(unsigned, maxRows_, MaxRows)
+		U_PROPERTY_IMP(float, refreshInterval_, RefreshInterval)
+
+	protected:
+		struct NodeStats
+		{
+			WeakPtr<Node> node_;
+			SceneStatsCost own_;
+			SceneStatsCost subtree_;
+		};
+
+		/// recompute the cost of the node's own components
+		void UpdateNode(Node* node);
+		void UpdateSubtree(Node* node);
+		/// add empty entries for the node and its children and mark them dirty
+		void TrackSubtree(Node* node);
+		void UpdateDirtyNodes();
+		void RemoveSubtree(Node* node, Node* parent);
+		/// add the difference to the node and its ancestors
+		void ApplyDelta(Node* node, const SceneStatsCost& delta);
+		void ComputeCost(Node* node, SceneStatsCost& cost);
+		int CountLitDrawables(Component* light);
+		void RebuildList();
+
+		void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
+		void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
+		void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
+		void HandleComponentRemoved(StringHash eventType, VariantMap& eventData);
+		void HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData);
+		void HandleSortButton(StringHash eventType, VariantMap& eventData);
+		void HandleRefreshButton(StringHash eventType, VariantMap& eventData);
+
+		// UI Attributes
+		SharedPtr<Text>		totalsText_;
+		SharedPtr<ListView> statsList_;
+		SharedPtr<Button>	sortButtons_[MAX_STATS_COLUMNS];
+		SharedPtr<Button>	refreshButton_;
+		// other Attributes
+		WeakPtr<Scene> scene_;
+		/// statistics by node id
+		HashMap<unsigned, NodeStats> stats_;
+		/// ids of the nodes whose components changed since the last update
+		HashSet<unsigned> dirtyNodes_;
+		/// scratch buffers reused for sorting and octree queries
+		PODVector<NodeStats*> ranked_;
+		PODVector<Drawable*> drawables_;
+		SceneStatsColumn sortColumn_;
+		bool listDirty_;
+		float refreshTimer_;
+	};
+}
@@ -50,6 +50,11 @@ namespace Urho3D
 	const StringHash A_CREATELOCALNODE_VAR("CreateLocalNode");
 	const StringHash A_CREATEREPNODE_VAR("CreateRepNode");
 
+	const StringHash A_VIEWPORTSINGLE_VAR("ViewportSingle");
+	const StringHash A_VIEWPORTSPLIT_VAR("ViewportSplit");
+	const StringHash A_VIEWPORTQUAD_VAR("ViewportQuad");
+	const StringHash A_FRAMESELECTION_VAR("FrameSelection");
+
 	const StringHash A_CREATECOMPONENT_VAR("CreateComponent");
 	const StringHash A_CREATEBUILTINOBJ_VAR("CreateBuiltinObject");
 